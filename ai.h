@@ -7,9 +7,29 @@
 //#defines
 #define MAX_SPEED (0.2f)
 #define MAX_SPEED2 (MAX_SPEED*MAX_SPEED)
+//entities one ai may spawn in a tick
+#define AI_MAX_SPAWNS (2)
+//ai entities each job decides for
+#define AI_GRAIN (64)
+//sliced states are decided every tick up to AI_LOD_NEAR from the player, every AI_LOD_MID_PERIOD ticks
+//up to AI_LOD_FAR, and every AI_LOD_FAR_PERIOD ticks past that. AI_LOD_NEAR has to cover what _ai_idle can see.
+#define AI_LOD_NEAR (60.0f)
+#define AI_LOD_FAR (120.0f)
+#define AI_LOD_MID_PERIOD (4)
+#define AI_LOD_FAR_PERIOD (16)
 //-------------------------------------
 
 //Typedefs
+
+//The states of an entity's ai run on 'self', a copy of the entity, and only read the rest of the world.
+//ai_apply then writes 'self' back and spawns what the states asked for, so every ai can decide at the same time.
+struct AI_command {
+  //the entity this was decided for
+  GenDex source;
+  Ent self;
+  Ent spawns[AI_MAX_SPAWNS];
+  int spawn_count;
+};
 //-------------------------------------
 
 //Function prototypes
@@ -19,11 +39,24 @@
 //-------------------------------------
 
 //Variables
+
+//The ai entities of the current tick in pool order, and their commands
+static struct {
+  Ent **ents;
+  AI_command *commands;
+  size_t count, capacity;
+} _ai_batch;
 //-------------------------------------
 
 //Function implementations
 
-static AI_statenum _ai_idle(Ent *ent) {
+static void _ai_spawn(AI_command *cmd, Ent spawn) {
+  assert(cmd->spawn_count<AI_MAX_SPAWNS&&"Too many spawns for one ai");
+  cmd->spawns[cmd->spawn_count++] = spawn;
+}
+
+static AI_statenum _ai_idle(Ent *ent, AI_command *cmd) {
+  (void)cmd;
   Ent *player = try_gendex(state->player);
 
   if(player!=NULL&&magmag2(sub2(ent->pos,player->pos))<m_square(50.0f)&&
@@ -35,7 +68,8 @@ static AI_statenum _ai_idle(Ent *ent) {
   return AI_STATE_NULL;
 }
 
-static AI_statenum _ai_move(Ent *ent) {
+static AI_statenum _ai_move(Ent *ent, AI_command *cmd) {
+  (void)cmd;
   Ent *target = try_gendex(ent->ai.target);
 
   //If target has been destroyed, revert to being idle
@@ -59,19 +93,20 @@ static AI_statenum _ai_move(Ent *ent) {
   return AI_STATE_NULL;
 }
 
-static AI_statenum _ai_attack(Ent *ent) {
+static AI_statenum _ai_attack(Ent *ent, AI_command *cmd) {
   Ent *target = try_gendex(ent->ai.target);
 
   //If target has been destroyed, revert to being idle
   if(target==NULL)
     return AI_STATE_IDLE;
 
-  fire_laser(ent);
+  _ai_spawn(cmd,laser_ent(ent,cmd->source));
 
   return AI_STATE_NULL;
 }
 
-static AI_statenum _ai_attack_idle(Ent *ent) {
+static AI_statenum _ai_attack_idle(Ent *ent, AI_command *cmd) {
+  (void)cmd;
   Ent *target = try_gendex(ent->ai.target);
 
   //If target has been destroyed, revert to being idle
@@ -92,18 +127,18 @@ static AI_statenum _ai_attack_idle(Ent *ent) {
   return AI_STATE_NULL;
 }
 
-static AI_statenum _ai_set_state(Ent *ent, AI_statenum nstate) {
+static AI_statenum _ai_set_state(Ent *ent, AI_command *cmd, AI_statenum nstate) {
   ent->ai.state = &_ai_state[nstate];
   ent->ai.tick_end = state->tick+ent->ai.state->ticks;
 
   if(ent->ai.state->action!=NULL)
-    return ent->ai.state->action(ent);
+    return ent->ai.state->action(ent,cmd);
   return AI_STATE_NULL;
 }
 
-static AI_statenum _ai_run_state(Ent *ent) {
+static AI_statenum _ai_run_state(Ent *ent, AI_command *cmd) {
   if(ent->ai.state->action!=NULL)
-      return ent->ai.state->action(ent);
+      return ent->ai.state->action(ent,cmd);
   return AI_STATE_NULL;
 }
 
@@ -112,29 +147,88 @@ static void ai_init(Ent *ent, AI_statenum sstate) {
   ent->ai.tick_end = state->tick+ent->ai.state->ticks;
 }
 
-static void ai_run(Ent *ent) {
-  if(ent->ai.state==NULL)
+//Runs the ai of 'ent' on a copy of it in 'cmd'. Only reads the world, so it can run on any thread.
+static void ai_decide(Ent *ent, AI_command *cmd) {
+  cmd->source = get_gendex(ent);
+  cmd->self = *ent;
+  cmd->spawn_count = 0;
+  Ent *self = &cmd->self;
+  if(self->ai.state==NULL)
     return;
 
   AI_statenum next;
-  if(state->tick>=ent->ai.tick_end)
-    next = _ai_set_state(ent,ent->ai.state->next);
+  if(state->tick>=self->ai.tick_end)
+    next = _ai_set_state(self,cmd,self->ai.state->next);
   else
-    next = _ai_run_state(ent);
+    next = _ai_run_state(self,cmd);
 
   while(next!=AI_STATE_NULL)
-    next = _ai_set_state(ent,next);
+    next = _ai_set_state(self,cmd,next);
+}
+
+//Writes back what the ai changed about 'ent', then queues what it spawned
+static void ai_apply(Ent *ent, AI_command *cmd) {
+  ent->angle = cmd->self.angle;
+  ent->vel = cmd->self.vel;
+  ent->ai = cmd->self.ai;
+  for(int i = 0; i<cmd->spawn_count; i++)
+    spawn_ent(cmd->spawns[i]);
+}
+
+//Whether 'ent' is decided this tick. A sliced state far from the player is only decided on every few ticks,
+//which ones depends on the entity's slot so that they don't all come due on the same tick.
+//A state whose time is up is always decided.
+static bool _ai_due(Ent *ent, Ent *player) {
+  const AI_state *s = ent->ai.state;
+  if(s==NULL||!s->sliced||(s->ticks>0&&state->tick>=ent->ai.tick_end))
+    return true;
+
+  float dist2 = player!=NULL ? magmag2(sub2(ent->pos,player->pos)) : INFINITY;
+  if(dist2<m_square(AI_LOD_NEAR))
+    return true;
+  Tick period = dist2<m_square(AI_LOD_FAR) ? AI_LOD_MID_PERIOD : AI_LOD_FAR_PERIOD;
+  return (state->tick+(Tick)(ent-state->ents))%period==0;
+}
+
+static void _ai_decide_range(void *arg, size_t begin, size_t end) {
+  (void)arg;
+  for(size_t i = begin; i<end; i++)
+    ai_decide(_ai_batch.ents[i],_ai_batch.commands+i);
+}
+
+//Decides for every ai entity across the job threads, then applies the commands in pool order,
+//so the spawns are queued in the same order however the deciding was split up
+static void ai_tick(void) {
+  Ent *player = try_gendex(state->player);
+  _ai_batch.count = 0;
+  for(Ent *ent = 0; (ent = ent_all_iter(ent));) {
+    if(!has_ent_prop(ent,EntProp_HasAI)||!_ai_due(ent,player))
+      continue;
+    if(_ai_batch.count==_ai_batch.capacity) {
+      _ai_batch.capacity = _ai_batch.capacity ? _ai_batch.capacity*2 : 64;
+      _ai_batch.ents = realloc(_ai_batch.ents,_ai_batch.capacity*sizeof(Ent *));
+      _ai_batch.commands = realloc(_ai_batch.commands,_ai_batch.capacity*sizeof(AI_command));
+    }
+    _ai_batch.ents[_ai_batch.count++] = ent;
+  }
+
+  job_for(_ai_decide_range,NULL,_ai_batch.count,AI_GRAIN);
+
+  for(size_t i = 0; i<_ai_batch.count; i++)
+    ai_apply(_ai_batch.ents[i],_ai_batch.commands+i);
 }
 
 static void ai_damage(Ent *to, GenDex *source) {
   if(!has_ent_prop(to,EntProp_Destructible))
     return;
 
-  //Go after attacker
+  //Go after attacker, the new state acts right away
   Ent *target = try_gendex(to->ai.target);
   if(target==NULL&&try_gendex(*source)!=NULL) {
-    to->ai.target = *source;
-    _ai_set_state(to,AI_STATE_MOVE);
+    AI_command cmd = { .source = get_gendex(to), .self = *to };
+    cmd.self.ai.target = *source;
+    _ai_set_state(&cmd.self,&cmd,AI_STATE_MOVE);
+    ai_apply(to,&cmd);
   }
 }
 //-------------------------------------
@@ -17,14 +17,20 @@ typedef enum {
   AI_STATE_MAX,
 }AI_statenum;
 
-typedef AI_statenum (*_ai_func_p1)(Ent *);
+//What the ai of one entity decided in a tick, see ai.h
+typedef struct AI_command AI_command;
+
+typedef AI_statenum (*_ai_func_p1)(Ent *, AI_command *);
 
 //'next' defines to what state the entity should switch after this state is over (TODO: implement time limit for states)
-//'action' gets called every frame for an entity and defines its behaviour, can change its state
+//'action' gets called every frame for an entity and defines its behaviour, can change its state.
+//It only changes the entity it's given, which is a copy, anything else it does goes into the command
+//'sliced' states only wait for something to happen, far from the player they're decided every few ticks, see _ai_due
 typedef struct {
   AI_statenum next;
   _ai_func_p1 action;
   uint64_t ticks;
+  bool sliced;
 }AI_state;
 //-------------------------------------
 
@@ -32,15 +38,17 @@ typedef struct {
 static void ai_init(Ent *ent, AI_statenum sstate);
 //TODO: rename?
 static void ai_damage(Ent *to, GenDex *source);
-static void ai_run(Ent *ent);
+static void ai_decide(Ent *ent, AI_command *cmd);
+static void ai_apply(Ent *ent, AI_command *cmd);
+static void ai_tick(void);
 
 //Internal
-static AI_statenum _ai_idle(Ent *ent);
-static AI_statenum _ai_move(Ent *ent);
-static AI_statenum _ai_attack_idle(Ent *ent);
-static AI_statenum _ai_attack(Ent *ent);
-static AI_statenum _ai_set_state(Ent *ent, AI_statenum nstate);
-static AI_statenum _ai_run_state(Ent *ent);
+static AI_statenum _ai_idle(Ent *ent, AI_command *cmd);
+static AI_statenum _ai_move(Ent *ent, AI_command *cmd);
+static AI_statenum _ai_attack_idle(Ent *ent, AI_command *cmd);
+static AI_statenum _ai_attack(Ent *ent, AI_command *cmd);
+static AI_statenum _ai_set_state(Ent *ent, AI_command *cmd, AI_statenum nstate);
+static AI_statenum _ai_run_state(Ent *ent, AI_command *cmd);
 //-------------------------------------
 
 //Variables
@@ -49,7 +57,7 @@ static AI_statenum _ai_run_state(Ent *ent);
 //Having this in a central place allows for easy tweaking of AI behaviour.
 static const AI_state _ai_state[AI_STATE_MAX] = {
   { .next = AI_STATE_NULL, .action = NULL, .ticks = 0},              //STATE_NULL
-  { .next = AI_STATE_IDLE, .action = _ai_idle, .ticks = 0},              //STATE_IDLE
+  { .next = AI_STATE_IDLE, .action = _ai_idle, .ticks = 0, .sliced = true}, //STATE_IDLE
   { .next = AI_STATE_MOVE, .action = _ai_move, .ticks = 0},              //STATE_MOVE
   { .next = AI_STATE_ATTACK1, .action = _ai_attack_idle, .ticks = 30},   //STATE_ATTACK0
   { .next = AI_STATE_ATTACK0, .action = _ai_attack, .ticks = 0},         //STATE_ATTACK1
@@ -0,0 +1,660 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/* Offline asset baking.
+ *
+ * baker.c runs every file the game loads through the same processing the
+ * game would do at startup, and writes the results as blobs that can be
+ * handed to the GPU as they are, listed in ASSET_MANIFEST. The load
+ * functions look their source up in the manifest first. Shipping (NDEBUG)
+ * builds then never open the source files; development builds still hash
+ * them so that a stale blob is ignored rather than silently used.
+ *
+ * Every blob starts with an asset_Tag, the mesh blobs are mcache files. */
+
+#define ASSET_DIR "baked"
+#define ASSET_MANIFEST ASSET_DIR "/manifest.txt"
+#define ASSET_MAX_ENTRIES (64)
+
+#define MESH_MAX_LODS (4)
+/* simplifying meshes smaller than this doesn't pay for the extra state */
+#define MESH_LOD_MIN_TRIANGLES (256)
+
+/* X(art, shader, model, texture, parts, part_count), see load_composite_mesh */
+#define ASSET_MESHES(X)                                                                 \
+  X(    Art_Ship,   Shader_Standard,     "./Bob.obj", "./Bob_Orange.png", NULL, 0)    \
+  X(Art_Asteroid,   Shader_Standard,"./Asteroid.obj",       "./Moon.png", NULL, 0)    \
+  X(   Art_Plane, Shader_ForceField,   "./Plane.obj",               NULL, NULL, 0)    \
+  X(   Art_Laser,      Shader_Laser,   "./LASER.obj",    "./Mineral.png", NULL, 0)    \
+  X( Art_Mineral,   Shader_Standard, "./Mineral.obj",    "./Mineral.png", NULL, 0)    \
+  /* pillars are the model on top of an upside-down copy of itself */               \
+  X(  Art_Pillar,   Shader_Standard,  "./Pillar.obj",     "./Pillar.png", ((Mat4[]) { \
+    translate4x4(vec3(0.0f, 2.0f, 0.0f)),                                              \
+    mul4x4(translate4x4(vec3(0.0f, -4.0f, 0.0f)), x_rotate4x4(PI_f)),                  \
+  }), 2)
+
+/* images drawn by the overlay on their own, and fonts */
+#define ASSET_IMAGES(X)
+#define ASSET_FONTS(X) X("./Orbitron-Regular.ttf")
+
+/* Small images the overlay draws, packed into one texture so that drawing
+ * them one after another never switches images. A white texel is packed
+ * after them for solid rectangles. */
+#define ASSET_ATLAS(X) X("./ui.png") X("./Gem.png")
+#define ASSET_ATLAS_NAME "./atlas"
+#define ASSET_ATLAS_WIDTH (1024)
+/* texels left empty between images */
+#define ASSET_ATLAS_GAP (1)
+
+/* Glyphs are stored once as signed distance fields rendered ASSET_FONT_SDF_SIZE
+ * pixels high, which the overlay scales to any size. ASSET_FONT_SIZE is what
+ * the ui draws text at unless told otherwise. */
+#define ASSET_FONT_SIZE (32)
+#define ASSET_FONT_SDF_SIZE (40)
+/* texels of distance field around each glyph, the outline sits at half intensity */
+#define ASSET_FONT_SDF_PADDING (5)
+#define ASSET_FONT_ATLAS_SIZE (512)
+#define ASSET_FONT_CHARS (256)
+#define ASSET_MAX_MIPS MIP_MAX_LEVELS
+
+#define ASSET_TEXTURE_MAGIC (0x31584554u) /* "TEX1" */
+#define ASSET_FONT_MAGIC    (0x31544e46u) /* "FNT1" */
+#define ASSET_ATLAS_MAGIC   (0x314c5441u) /* "ATL1" */
+#define ASSET_VERSION (5u)
+
+#define X(path) + 1
+/* the rect of the white texel follows those of the images */
+enum { ASSET_ATLAS_WHITE = 0 ASSET_ATLAS(X), ASSET_ATLAS_RECTS };
+#undef X
+
+typedef struct {
+  uint32_t magic, version;
+  /* of the source file and everything else the blob was built from */
+  uint64_t hash;
+} asset_Tag;
+
+/* followed by each mip level, largest first, bcn_level_size bytes each */
+typedef struct {
+  asset_Tag tag;
+  uint32_t width, height;
+  uint32_t mip_count;
+  uint32_t flipped;
+  /* a bcn_Format */
+  uint32_t format;
+} asset_TextureHeader;
+
+/* followed by ASSET_FONT_CHARS stbtt_packedchar and the R8 distance field
+ * atlas, both in pixels at sdf_size */
+typedef struct {
+  asset_Tag tag;
+  int32_t sdf_size;
+  float ascent;
+  /* how much the field changes over one texel, out of 1 */
+  float spread;
+  uint32_t atlas_size;
+} asset_FontHeader;
+
+typedef struct {
+  uint16_t x, y, w, h;
+} asset_Rect;
+
+/* followed by ASSET_ATLAS_RECTS asset_Rect, in ASSET_ATLAS order, and the
+ * RGBA8 atlas, `height` rows ASSET_ATLAS_WIDTH texels wide */
+typedef struct {
+  asset_Tag tag;
+  uint32_t width, height;
+} asset_AtlasHeader;
+
+typedef struct {
+  const asset_TextureHeader *header;
+  const uint8_t *levels[ASSET_MAX_MIPS];
+  fio_Map _map;
+} asset_Texture;
+
+typedef struct {
+  const asset_AtlasHeader *header;
+  const asset_Rect *rects;
+  const uint8_t *pixels;
+  fio_Map _map;
+} asset_Atlas;
+
+typedef struct {
+  const asset_FontHeader *header;
+  const stbtt_packedchar *chars;
+  const uint8_t *atlas;
+  fio_Map _map;
+} asset_Font;
+
+typedef struct {
+  char kind[16];
+  char source[128];
+  char blob[128];
+} asset_Entry;
+
+static struct {
+  asset_Entry entries[ASSET_MAX_ENTRIES];
+  size_t entry_count;
+} _asset_state;
+
+/* ----------------------------- manifest ----------------------------- */
+
+/* Reads ASSET_MANIFEST, lines of "kind source blob". Without one nothing is baked. */
+__attribute__((unused))
+static void asset_init(void) {
+  _asset_state.entry_count = 0;
+  FILE *f = fopen(ASSET_MANIFEST, "r");
+  if (f == NULL) return;
+  asset_Entry e;
+  while (_asset_state.entry_count < ASSET_MAX_ENTRIES &&
+         fscanf(f, "%15s %127s %127s", e.kind, e.source, e.blob) == 3)
+    _asset_state.entries[_asset_state.entry_count++] = e;
+  fclose(f);
+}
+
+__attribute__((unused))
+static const char *asset_find(const char *kind, const char *source) {
+  for (size_t i = 0; i < _asset_state.entry_count; i++) {
+    asset_Entry *e = _asset_state.entries + i;
+    if (strcmp(e->kind, kind) == 0 && strcmp(e->source, source) == 0)
+      return e->blob;
+  }
+  return NULL;
+}
+
+/* ------------------------------ hashing ----------------------------- */
+
+__attribute__((unused))
+static uint64_t asset_mesh_hash(const char *src, size_t size, const Mat4 *parts, size_t part_count) {
+  /* anything that changes the processed mesh has to be part of its hash,
+   * changes to the processing itself should bump MCACHE_VERSION */
+  uint64_t hash = mcache_hash(src, size, MCACHE_HASH_SEED);
+  hash = mcache_hash(parts, part_count*sizeof(Mat4), hash);
+  return mcache_hash((uint32_t[]) { MESH_MAX_LODS, MESH_LOD_MIN_TRIANGLES }, 2*sizeof(uint32_t), hash);
+}
+
+/* hashes the file at `path` followed by `salt_size` bytes of `salt` */
+__attribute__((unused))
+static bool asset_source_hash(const char *path, const void *salt, size_t salt_size, uint64_t *hash) {
+  fio_Map src;
+  if (!fio_map(path, &src)) return false;
+  *hash = mcache_hash(salt, salt_size, mcache_hash(src.data, src.size, MCACHE_HASH_SEED));
+  fio_unmap(&src);
+  return true;
+}
+
+/* Maps the blob baked from `source` if there is one and it's current,
+ * development builds compare its tag to what `hash` makes of the sources */
+static bool _asset_open(const char *kind, const char *source, const void *salt, size_t salt_size,
+                        bool (*hash_sources)(const char*, const void*, size_t, uint64_t*),
+                        uint32_t magic, size_t header_size, fio_Map *map) {
+  const char *blob = asset_find(kind, source);
+  if (blob == NULL || !fio_map(blob, map)) return false;
+  const asset_Tag *tag = (const asset_Tag*)map->data;
+  bool ok = map->size >= header_size && tag->magic == magic && tag->version == ASSET_VERSION;
+#ifndef NDEBUG
+  uint64_t hash;
+  ok = ok && hash_sources(source, salt, salt_size, &hash) && hash == tag->hash;
+#else
+  (void)salt;
+  (void)salt_size;
+  (void)hash_sources;
+#endif
+  if (!ok) {
+    fprintf(stderr, "Ignoring stale baked asset %s\n", blob);
+    fio_unmap(map);
+  }
+  return ok;
+}
+
+/* ------------------------------ meshes ------------------------------ */
+
+/* Copies the unrolled (POSITION3, UV2, NORMAL3) model once per transform in
+ * `parts` and places each copy with it. The transforms should be rigid,
+ * because normals only get their rotation applied. */
+static obj_Unrolled _asset_bake_parts(obj_Unrolled *unrolled, size_t vertex_count, size_t index_count,
+                                      const Mat4 *parts, size_t part_count) {
+  obj_Unrolled baked = {
+    .vertices = (float*)malloc(vertex_count*part_count*8*sizeof(float)),
+    .indices = (uint32_t*)malloc(index_count*part_count*sizeof(uint32_t)),
+  };
+
+  for (size_t p = 0; p < part_count; p++) {
+    Mat4 m = parts[p];
+    float *dst = baked.vertices + p*vertex_count*8;
+    for (size_t v = 0; v < vertex_count; v++) {
+      float *src = unrolled->vertices + v*8;
+      Vec4 pos = mul4x44(m, vec4(src[0], src[1], src[2], 1.0f));
+      Vec4 nrm = mul4x44(m, vec4(src[5], src[6], src[7], 0.0f));
+      Vec3 n = norm3(vec3(nrm.x, nrm.y, nrm.z));
+      memcpy(dst + v*8, (float[8]) { pos.x, pos.y, pos.z, src[3], src[4], n.x, n.y, n.z }, 8*sizeof(float));
+    }
+
+    /* a mirroring transform would turn the triangles inside out */
+    Vec3 cx = vec3(m.x.x, m.x.y, m.x.z), cy = vec3(m.y.x, m.y.y, m.y.z), cz = vec3(m.z.x, m.z.y, m.z.z);
+    bool flip = dot3(cross3(cx, cy), cz) < 0.0f;
+    uint32_t *idx = baked.indices + p*index_count;
+    for (size_t i = 0; i < index_count; i++)
+      idx[i] = (uint32_t)(unrolled->indices[flip ? i - i%3 + 2 - i%3 : i] + p*vertex_count);
+  }
+  return baked;
+}
+
+static uint16_t _asset_unorm16(float x, float min, float max) {
+  float t = max > min ? (x - min)/(max - min) : 0.0f;
+  return (uint16_t)(fminf(fmaxf(t, 0.0f), 1.0f)*65535.0f + 0.5f);
+}
+
+static int16_t _asset_snorm16(float x) {
+  return (int16_t)lrintf(fminf(fmaxf(x, -1.0f), 1.0f)*32767.0f);
+}
+
+/* Packs the 8 float vertices obj_unroll_pun lays out into mcache_Vertex,
+ * positions and uvs relative to the ranges recorded in `header` */
+__attribute__((unused))
+static void asset_quantize(mcache_Header *header, const float *vertices, size_t vertex_count, mcache_Vertex *out) {
+  for (int k = 0; k < 3; k++) {
+    header->bounds_min[k] = INFINITY;
+    header->bounds_max[k] = -INFINITY;
+  }
+  for (int k = 0; k < 2; k++) {
+    header->uv_min[k] = INFINITY;
+    header->uv_max[k] = -INFINITY;
+  }
+  for (size_t v = 0; v < vertex_count; v++) {
+    for (size_t k = 0; k < 3; k++) {
+      header->bounds_min[k] = fminf(header->bounds_min[k], vertices[v*8+k]);
+      header->bounds_max[k] = fmaxf(header->bounds_max[k], vertices[v*8+k]);
+    }
+    for (size_t k = 0; k < 2; k++) {
+      header->uv_min[k] = fminf(header->uv_min[k], vertices[v*8+3+k]);
+      header->uv_max[k] = fmaxf(header->uv_max[k], vertices[v*8+3+k]);
+    }
+  }
+
+  for (size_t v = 0; v < vertex_count; v++) {
+    const float *src = vertices + v*8;
+    mcache_Vertex *dst = out + v;
+    *dst = (mcache_Vertex) { 0 };
+    for (int k = 0; k < 3; k++)
+      dst->position[k] = _asset_unorm16(src[k], header->bounds_min[k], header->bounds_max[k]);
+    for (int k = 0; k < 2; k++)
+      dst->uv[k] = _asset_unorm16(src[3+k], header->uv_min[k], header->uv_max[k]);
+
+    /* project onto the octahedron |x|+|y|+|z| = 1, then fold the lower half over the upper one */
+    const float *n = src + 5;
+    float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    if (l1 == 0.0f) continue;
+    float x = n[0]/l1, y = n[1]/l1;
+    if (n[2] < 0.0f) {
+      float fx = (1.0f - fabsf(y))*(x >= 0.0f ? 1.0f : -1.0f);
+      float fy = (1.0f - fabsf(x))*(y >= 0.0f ? 1.0f : -1.0f);
+      x = fx;
+      y = fy;
+    }
+    dst->normal[0] = _asset_snorm16(x);
+    dst->normal[1] = _asset_snorm16(y);
+  }
+}
+
+/* Runs a parsed model through simplification and cache optimization,
+ * leaving the final quantized vertices and indices in `out_vertices`/`out_indices`.
+ * The indices are 16 bit whenever that can address every vertex, see index_size. */
+__attribute__((unused))
+static mcache_Header asset_process_mesh(const char *path, const char *input, const Mat4 *parts, size_t part_count,
+                                        mcache_Vertex **out_vertices, void **out_indices) {
+  obj_Result res = obj_parse(input);
+  size_t vertex_count;
+  obj_Unrolled unrolled = obj_unroll_pun(&res, &vertex_count);
+  size_t index_count = res.index_count;
+  obj_dispose(&res);
+
+  if (part_count > 0) {
+    obj_Unrolled baked = _asset_bake_parts(&unrolled, vertex_count, index_count, parts, part_count);
+    obj_dispose_unrolled(&unrolled);
+    unrolled = baked;
+    vertex_count *= part_count;
+    index_count *= part_count;
+  }
+
+  mcache_Header header = {
+    .stride = sizeof(mcache_Vertex),
+    .lods[0] = { .index_count = (uint32_t)index_count },
+    .lod_count = 1,
+  };
+
+  /* every LOD indexes the same vertices, and they're stored back to back */
+  uint32_t *indices = (uint32_t*)malloc(index_count*MESH_MAX_LODS*sizeof(uint32_t));
+  memcpy(indices, unrolled.indices, index_count*sizeof(uint32_t));
+  size_t index_total = index_count;
+  if (index_count/3 >= MESH_LOD_MIN_TRIANGLES)
+    for (; header.lod_count < MESH_MAX_LODS; header.lod_count++) {
+      mcache_Lod lod = { .index_offset = (uint32_t)index_total };
+      lod.index_count = (uint32_t)meshopt_simplify(indices + index_total,
+        unrolled.indices, index_count, unrolled.vertices, vertex_count, 8,
+        index_count >> header.lod_count, &lod.error);
+
+      /* stop once the simplifier runs out of edges it can safely collapse */
+      if (lod.index_count == 0 ||
+          lod.index_count > header.lods[header.lod_count-1].index_count*3/4)
+        break;
+      header.lods[header.lod_count] = lod;
+      index_total += lod.index_count;
+    }
+
+  /* reorder each LOD's triangles for the post-transform cache and overdraw,
+   * then lay the vertices out in the order the full mesh first uses them */
+  float acmr = meshopt_acmr(indices, index_count);
+  uint32_t *scratch = (uint32_t*)malloc(index_count*sizeof(uint32_t));
+  uint32_t *clusters = (uint32_t*)malloc((index_count/3 + 1)*sizeof(uint32_t));
+  for (size_t i = 0; i < header.lod_count; i++) {
+    uint32_t *lod_indices = indices + header.lods[i].index_offset;
+    size_t lod_index_count = header.lods[i].index_count;
+    size_t cluster_count = meshopt_optimize_vertex_cache(scratch, lod_indices, lod_index_count,
+                                                         vertex_count, clusters);
+    meshopt_optimize_overdraw(lod_indices, scratch, lod_index_count,
+                              clusters, cluster_count, unrolled.vertices, 8);
+  }
+  float *vertices = (float*)malloc(vertex_count*8*sizeof(float));
+  vertex_count = meshopt_optimize_vertex_fetch(vertices, indices, index_total,
+                                               unrolled.vertices, vertex_count, 8);
+  printf("%s has %u LODs, ACMR %.3f -> %.3f\n", path, header.lod_count,
+         acmr, meshopt_acmr(indices, index_count));
+  free(scratch);
+  free(clusters);
+  obj_dispose_unrolled(&unrolled);
+
+  header.vertex_count = (uint32_t)vertex_count;
+  header.index_count = (uint32_t)index_total;
+  mcache_Vertex *quantized = (mcache_Vertex*)malloc(vertex_count*sizeof(mcache_Vertex));
+  asset_quantize(&header, vertices, vertex_count, quantized);
+  free(vertices);
+
+  header.index_size = vertex_count <= UINT16_MAX+1 ? 2 : 4;
+  *out_indices = indices;
+  if (header.index_size == 2) {
+    uint16_t *narrow = (uint16_t*)malloc(index_total*sizeof(uint16_t));
+    for (size_t i = 0; i < index_total; i++)
+      narrow[i] = (uint16_t)indices[i];
+    free(indices);
+    *out_indices = narrow;
+  }
+  *out_vertices = quantized;
+  return header;
+}
+
+/* ----------------------------- textures ----------------------------- */
+
+/* Mesh textures are baked as RGBA8 and compressed, each format listed under
+ * its own kind. Images are only baked as RGBA8, the overlay draws them 1:1. */
+__attribute__((unused))
+static const char *asset_texture_kind(bool flipped, bcn_Format format) {
+  static const char *kinds[bcn_Format_COUNT] = { "texture", "texture-bc1", "texture-bc3", "texture-bc7" };
+  return flipped ? kinds[format] : "image";
+}
+
+/* Maps the baked texture for `source`, `flipped` as load_texture flips mesh
+ * textures, in the first format that is both in the mask `formats` and was
+ * baked. Formats are tried in bcn_pick's order: the baker only writes BC3 for
+ * textures with alpha, so trying it first gives those BC3 before BC7, and
+ * opaque ones BC7, then BC1. RGBA8 comes last. */
+__attribute__((unused))
+static bool asset_open_texture(const char *source, bool flipped, uint32_t formats, asset_Texture *tex) {
+  static const bcn_Format order[] = { bcn_Format_BC3, bcn_Format_BC7, bcn_Format_BC1, bcn_Format_RGBA8 };
+  *tex = (asset_Texture) { 0 };
+  uint32_t salt = flipped;
+  for (size_t o = 0; o < sizeof(order)/sizeof(order[0]); o++) {
+    bcn_Format format = order[o];
+    if (!(formats & (1u << format)) || (!flipped && format != bcn_Format_RGBA8)) continue;
+    if (!_asset_open(asset_texture_kind(flipped, format), source, &salt, sizeof(salt),
+                     asset_source_hash, ASSET_TEXTURE_MAGIC, sizeof(asset_TextureHeader), &tex->_map))
+      continue;
+
+    const asset_TextureHeader *header = (const asset_TextureHeader*)tex->_map.data;
+    const uint8_t *level = (const uint8_t*)(header + 1);
+    size_t size = sizeof(*header);
+    uint32_t w = header->width, h = header->height;
+    for (uint32_t i = 0; i < header->mip_count && i < ASSET_MAX_MIPS; i++) {
+      tex->levels[i] = level;
+      level += bcn_level_size(format, w, h);
+      size += bcn_level_size(format, w, h);
+      w = w > 1 ? w/2 : 1;
+      h = h > 1 ? h/2 : 1;
+    }
+    if (header->format != (uint32_t)format || header->mip_count > ASSET_MAX_MIPS || size != tex->_map.size) {
+      fio_unmap(&tex->_map);
+      *tex = (asset_Texture) { 0 };
+      continue;
+    }
+    tex->header = header;
+    return true;
+  }
+  return false;
+}
+
+__attribute__((unused))
+static void asset_close_texture(asset_Texture *tex) {
+  fio_unmap(&tex->_map);
+  *tex = (asset_Texture) { 0 };
+}
+
+/* ------------------------------- atlas ------------------------------ */
+
+static const char *asset_atlas_sources[] = {
+#define X(path) path,
+  ASSET_ATLAS(X)
+#undef X
+};
+
+/* Index of the rect `path` has in the atlas, -1 if it isn't packed there */
+__attribute__((unused))
+static int asset_atlas_find(const char *path) {
+  for (int i = 0; i < ASSET_ATLAS_WHITE; i++)
+    if (strcmp(asset_atlas_sources[i], path) == 0)
+      return i;
+  return -1;
+}
+
+/* hashes every image of the atlas, in order, and then `salt`. The atlas is
+ * baked under ASSET_ATLAS_NAME, which isn't a file. */
+__attribute__((unused))
+static bool asset_atlas_hash(const char *name, const void *salt, size_t salt_size, uint64_t *hash) {
+  (void)name;
+  *hash = MCACHE_HASH_SEED;
+  for (int i = 0; i < ASSET_ATLAS_WHITE; i++) {
+    fio_Map src;
+    if (!fio_map(asset_atlas_sources[i], &src)) return false;
+    *hash = mcache_hash(src.data, src.size, *hash);
+    fio_unmap(&src);
+  }
+  *hash = mcache_hash(salt, salt_size, *hash);
+  return true;
+}
+
+/* everything besides the images that a baked atlas is made from */
+static const uint32_t asset_atlas_salt[] = { ASSET_ATLAS_WIDTH, ASSET_ATLAS_GAP };
+
+/* Places each of `count` rects, by their w and h, on shelves `width` wide,
+ * tallest first. Returns the height taken, 0 if a rect is wider than `width`. */
+__attribute__((unused))
+static uint32_t asset_pack_rects(asset_Rect *rects, size_t count, uint32_t width) {
+  size_t order[ASSET_MAX_ENTRIES];
+  assert(count <= ASSET_MAX_ENTRIES && "Too many rects to pack");
+  for (size_t i = 0; i < count; i++) {
+    size_t j = i;
+    for (; j > 0 && rects[order[j-1]].h < rects[i].h; j--)
+      order[j] = order[j-1];
+    order[j] = i;
+  }
+
+  uint32_t x = 0, y = 0, shelf_height = 0;
+  for (size_t i = 0; i < count; i++) {
+    asset_Rect *r = rects + order[i];
+    if (r->w > width) return 0;
+    if (x + r->w > width) {
+      x = 0;
+      y += shelf_height + ASSET_ATLAS_GAP;
+      shelf_height = 0;
+    }
+    r->x = (uint16_t)x;
+    r->y = (uint16_t)y;
+    x += r->w + ASSET_ATLAS_GAP;
+    shelf_height = r->h > shelf_height ? r->h : shelf_height;
+  }
+  return y + shelf_height;
+}
+
+/* Decodes and packs every ASSET_ATLAS image. Returns the rects followed by
+ * the pixels, as an asset_AtlasHeader is followed by them, `size` bytes in
+ * all, or NULL if an image can't be read or the atlas would be too tall. */
+__attribute__((unused))
+static uint8_t *asset_pack_atlas(asset_AtlasHeader *header, size_t *size) {
+  cp_image_t images[ASSET_ATLAS_WHITE + 1];
+  asset_Rect rects[ASSET_ATLAS_RECTS];
+  for (int i = 0; i < ASSET_ATLAS_WHITE; i++) {
+    images[i] = cp_load_png(asset_atlas_sources[i]);
+    if (images[i].pix == NULL) {
+      for (int j = 0; j < i; j++)
+        cp_free_png(images + j);
+      return NULL;
+    }
+    rects[i] = (asset_Rect) { .w = (uint16_t)images[i].w, .h = (uint16_t)images[i].h };
+  }
+  rects[ASSET_ATLAS_WHITE] = (asset_Rect) { .w = 1, .h = 1 };
+
+  uint32_t height = asset_pack_rects(rects, ASSET_ATLAS_RECTS, ASSET_ATLAS_WIDTH);
+  uint8_t *data = NULL;
+  if (height > 0 && height <= ASSET_ATLAS_WIDTH) {
+    *header = (asset_AtlasHeader) { .width = ASSET_ATLAS_WIDTH, .height = height };
+    *size = sizeof(rects) + (size_t)ASSET_ATLAS_WIDTH*height*4;
+    data = (uint8_t*)calloc(1, *size);
+    memcpy(data, rects, sizeof(rects));
+    uint8_t *pixels = data + sizeof(rects);
+    for (int i = 0; i < ASSET_ATLAS_WHITE; i++)
+      for (uint16_t r = 0; r < rects[i].h; r++)
+        memcpy(pixels + ((size_t)(rects[i].y + r)*ASSET_ATLAS_WIDTH + rects[i].x)*4,
+               images[i].pix + (size_t)r*rects[i].w, (size_t)rects[i].w*4);
+    asset_Rect white = rects[ASSET_ATLAS_WHITE];
+    memset(pixels + ((size_t)white.y*ASSET_ATLAS_WIDTH + white.x)*4, 0xff, 4);
+  }
+  for (int i = 0; i < ASSET_ATLAS_WHITE; i++)
+    cp_free_png(images + i);
+  return data;
+}
+
+__attribute__((unused))
+static bool asset_open_atlas(asset_Atlas *atlas) {
+  *atlas = (asset_Atlas) { 0 };
+  if (!_asset_open("atlas", ASSET_ATLAS_NAME, asset_atlas_salt, sizeof(asset_atlas_salt),
+                   asset_atlas_hash, ASSET_ATLAS_MAGIC, sizeof(asset_AtlasHeader), &atlas->_map))
+    return false;
+
+  const asset_AtlasHeader *h = (const asset_AtlasHeader*)atlas->_map.data;
+  if (h->width != ASSET_ATLAS_WIDTH ||
+      sizeof(*h) + ASSET_ATLAS_RECTS*sizeof(asset_Rect) + (size_t)h->width*h->height*4 != atlas->_map.size) {
+    fio_unmap(&atlas->_map);
+    return false;
+  }
+  atlas->header = h;
+  atlas->rects = (const asset_Rect*)(h + 1);
+  atlas->pixels = (const uint8_t*)(atlas->rects + ASSET_ATLAS_RECTS);
+  return true;
+}
+
+__attribute__((unused))
+static void asset_close_atlas(asset_Atlas *atlas) {
+  fio_unmap(&atlas->_map);
+  *atlas = (asset_Atlas) { 0 };
+}
+
+/* ------------------------------- fonts ------------------------------ */
+
+/* Bytes of the glyph table and atlas following an asset_FontHeader */
+#define ASSET_FONT_DATA_SIZE \
+  (ASSET_FONT_CHARS*sizeof(stbtt_packedchar) + ASSET_FONT_ATLAS_SIZE*ASSET_FONT_ATLAS_SIZE)
+
+/* everything besides the font file that a baked font is made from */
+static const int32_t asset_font_salt[] = {
+  ASSET_FONT_SDF_SIZE, ASSET_FONT_SDF_PADDING, ASSET_FONT_ATLAS_SIZE, ASSET_FONT_CHARS,
+};
+
+/* Renders the first ASSET_FONT_CHARS glyphs of `ttf` as distance fields and
+ * packs them in rows into `data`, which has to be ASSET_FONT_DATA_SIZE bytes */
+__attribute__((unused))
+static bool asset_pack_font(const uint8_t *ttf, asset_FontHeader *header, uint8_t *data) {
+  stbtt_fontinfo info;
+  int ascent;
+  if (!stbtt_InitFont(&info, ttf, 0)) return false;
+  float scale = stbtt_ScaleForPixelHeight(&info, (float)ASSET_FONT_SDF_SIZE);
+  stbtt_GetFontVMetrics(&info, &ascent, NULL, NULL);
+  /* the field reaches 0 and 255 ASSET_FONT_SDF_PADDING texels out- and inside the outline */
+  float dist_scale = 128.0f/ASSET_FONT_SDF_PADDING;
+  *header = (asset_FontHeader) {
+    .sdf_size = ASSET_FONT_SDF_SIZE,
+    .ascent = (float)ascent*scale,
+    .spread = dist_scale/255.0f,
+    .atlas_size = ASSET_FONT_ATLAS_SIZE,
+  };
+
+  stbtt_packedchar *chars = (stbtt_packedchar*)data;
+  uint8_t *atlas = data + ASSET_FONT_CHARS*sizeof(stbtt_packedchar);
+  memset(atlas, 0, ASSET_FONT_ATLAS_SIZE*ASSET_FONT_ATLAS_SIZE);
+  int x = 0, y = 0, row_height = 0;
+  for (int c = 0; c < ASSET_FONT_CHARS; c++) {
+    int advance, w = 0, h = 0, xoff = 0, yoff = 0;
+    stbtt_GetCodepointHMetrics(&info, c, &advance, NULL);
+    uint8_t *sdf = stbtt_FindGlyphIndex(&info, c) == 0 ? NULL :
+      stbtt_GetCodepointSDF(&info, scale, c, ASSET_FONT_SDF_PADDING, 128, dist_scale, &w, &h, &xoff, &yoff);
+    if (x + w > ASSET_FONT_ATLAS_SIZE) {
+      x = 0;
+      y += row_height + 1;
+      row_height = 0;
+    }
+    if (y + h > ASSET_FONT_ATLAS_SIZE) {
+      stbtt_FreeSDF(sdf, NULL);
+      return false;
+    }
+    for (int r = 0; r < h; r++)
+      memcpy(atlas + (size_t)(y + r)*ASSET_FONT_ATLAS_SIZE + x, sdf + r*w, (size_t)w);
+    stbtt_FreeSDF(sdf, NULL);
+
+    chars[c] = (stbtt_packedchar) {
+      .x0 = (unsigned short)x, .y0 = (unsigned short)y,
+      .x1 = (unsigned short)(x + w), .y1 = (unsigned short)(y + h),
+      .xoff = (float)xoff, .yoff = (float)yoff,
+      .xoff2 = (float)(xoff + w), .yoff2 = (float)(yoff + h),
+      .xadvance = (float)advance*scale,
+    };
+    x += w + 1;
+    row_height = h > row_height ? h : row_height;
+  }
+  return true;
+}
+
+__attribute__((unused))
+static bool asset_open_font(const char *source, asset_Font *font) {
+  *font = (asset_Font) { 0 };
+  if (!_asset_open("font", source, asset_font_salt, sizeof(asset_font_salt),
+                   asset_source_hash, ASSET_FONT_MAGIC, sizeof(asset_FontHeader), &font->_map))
+    return false;
+
+  const asset_FontHeader *h = (const asset_FontHeader*)font->_map.data;
+  if (h->sdf_size != ASSET_FONT_SDF_SIZE || h->atlas_size != ASSET_FONT_ATLAS_SIZE ||
+      sizeof(*h) + ASSET_FONT_DATA_SIZE != font->_map.size) {
+    fio_unmap(&font->_map);
+    return false;
+  }
+  font->header = h;
+  font->chars = (const stbtt_packedchar*)(h + 1);
+  font->atlas = (const uint8_t*)(font->chars + ASSET_FONT_CHARS);
+  return true;
+}
+
+__attribute__((unused))
+static void asset_close_font(asset_Font *font) {
+  fio_unmap(&font->_map);
+  *font = (asset_Font) { 0 };
+}
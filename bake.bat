@@ -8,6 +8,7 @@ sokol\shdc\win32\sokol-shdc.exe --input shaders.glsl --output build\shaders.glsl
 :: Compile the game
 pushd build
 cl /nologo /Z7 /FC ..\main.c /link user32.lib gdi32.lib
+cl /nologo /Z7 /FC ..\baker.c
 popd
 
 popd
@@ -0,0 +1,283 @@
+/* Offline asset baker, see asset.h. Run from the project root as build/baker,
+ * it only rebakes assets whose sources changed since the last run. */
+#ifndef __GNUC__
+#define __attribute__(unused)
+#endif
+
+#define CUTE_PNG_IMPLEMENTATION
+#include "cute_png.h"
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <sys/stat.h>
+#endif
+
+#include <math.h>
+#include "math.h"
+#include "fio.h"
+#define OBJ_QUIET
+#include "obj.h"
+#include "meshopt.h"
+#include "mcache.h"
+#include "mip.h"
+#include "bcn.h"
+#include "asset.h"
+
+static FILE *manifest;
+static size_t baked_count, skipped_count;
+
+/* `path` with its directories stripped, inside ASSET_DIR, with `ext` appended */
+static void blob_path(char *out, size_t size, const char *path, const char *ext) {
+  const char *name = strrchr(path, '/');
+  snprintf(out, size, "%s/%s%s", ASSET_DIR, name ? name+1 : path, ext);
+}
+
+static bool already_listed(const char *kind, const char *source) {
+  return asset_find(kind, source) != NULL;
+}
+
+static void list(const char *kind, const char *source, const char *blob) {
+  assert(_asset_state.entry_count < ASSET_MAX_ENTRIES && "Too many assets for the manifest");
+  fprintf(manifest, "%s %s %s\n", kind, source, blob);
+  asset_Entry *e = _asset_state.entries + _asset_state.entry_count++;
+  snprintf(e->kind, sizeof(e->kind), "%s", kind);
+  snprintf(e->source, sizeof(e->source), "%s", source);
+  snprintf(e->blob, sizeof(e->blob), "%s", blob);
+}
+
+/* a blob whose tag already matches doesn't need to be rebaked */
+static bool up_to_date(const char *blob, uint32_t magic, uint32_t version, uint64_t hash) {
+  fio_Map map;
+  if (!fio_map(blob, &map)) return false;
+  const asset_Tag *tag = (const asset_Tag*)map.data;
+  bool ok = map.size >= sizeof(asset_Tag) && tag->magic == magic && tag->version == version && tag->hash == hash;
+  fio_unmap(&map);
+  return ok;
+}
+
+static bool write_blob(const char *blob, const void *header, size_t header_size, const void *data, size_t size) {
+  FILE *f = fopen(blob, "wb");
+  if (f == NULL) return false;
+  bool ok = fwrite(header, header_size, 1, f) == 1 && fwrite(data, 1, size, f) == size;
+  return fclose(f) == 0 && ok;
+}
+
+static bool bake_mesh(const char *source, const Mat4 *parts, size_t part_count) {
+  char blob[256];
+  blob_path(blob, sizeof(blob), source, ".mesh");
+  if (already_listed("mesh", source)) return true;
+
+  char *input = fio_read_text(source);
+  if (input == NULL) return false;
+  uint64_t hash = asset_mesh_hash(input, strlen(input), parts, part_count);
+  bool ok = true;
+  if (up_to_date(blob, MCACHE_MAGIC, MCACHE_VERSION, hash))
+    skipped_count++;
+  else {
+    mcache_Vertex *vertices;
+    void *indices;
+    mcache_Header header = asset_process_mesh(source, input, parts, part_count, &vertices, &indices);
+    header.hash = hash;
+    ok = mcache_save(blob, &header, vertices, indices);
+    free(vertices);
+    free(indices);
+    baked_count++;
+  }
+  free(input);
+  if (ok) list("mesh", source, blob);
+  return ok;
+}
+
+/* `source` baked as `format`, next to the blobs of its other formats */
+static void texture_blob(char *out, size_t size, const char *source, bool flipped, bcn_Format format) {
+  static const char *exts[bcn_Format_COUNT] = { ".tex", ".bc1.tex", ".bc3.tex", ".bc7.tex" };
+  char ext[32];
+  snprintf(ext, sizeof(ext), "%s%s", flipped ? ".flipped" : "", exts[format]);
+  blob_path(out, size, source, ext);
+}
+
+/* Images are only baked as RGBA8. Mesh textures also get the compressed
+ * formats bcn_pick could choose for them. */
+static uint32_t texture_formats(bool flipped, uint32_t width, uint32_t height, bool opaque) {
+  uint32_t formats = 1u << bcn_Format_RGBA8;
+  if (!flipped || width % 4 != 0 || height % 4 != 0) return formats;
+  return formats | 1u << bcn_Format_BC7 | 1u << (opaque ? bcn_Format_BC1 : bcn_Format_BC3);
+}
+
+/* the formats `blob`, a current RGBA8 texture, should also be baked in */
+static uint32_t baked_texture_formats(const char *blob, bool flipped) {
+  fio_Map map;
+  if (!fio_map(blob, &map)) return 0;
+  const asset_TextureHeader *header = (const asset_TextureHeader*)map.data;
+  if (map.size < sizeof(*header) + bcn_level_size(bcn_Format_RGBA8, header->width, header->height)) {
+    fio_unmap(&map);
+    return 0;
+  }
+  uint32_t formats = texture_formats(flipped, header->width, header->height,
+                                     bcn_opaque((const uint8_t*)(header + 1), header->width, header->height));
+  fio_unmap(&map);
+  return formats;
+}
+
+static bool bake_texture(const char *source, bool flipped) {
+  /* meshes without a texture */
+  if (source == NULL) return true;
+  if (already_listed(asset_texture_kind(flipped, bcn_Format_RGBA8), source)) return true;
+
+  uint32_t salt = flipped;
+  uint64_t hash;
+  if (!asset_source_hash(source, &salt, sizeof(salt), &hash)) return false;
+
+  char blobs[bcn_Format_COUNT][256];
+  uint32_t current = 0;
+  for (int f = 0; f < bcn_Format_COUNT; f++) {
+    texture_blob(blobs[f], sizeof(blobs[f]), source, flipped, (bcn_Format)f);
+    if (up_to_date(blobs[f], ASSET_TEXTURE_MAGIC, ASSET_VERSION, hash))
+      current |= 1u << f;
+  }
+  uint32_t formats = (current & 1u << bcn_Format_RGBA8) ? baked_texture_formats(blobs[bcn_Format_RGBA8], flipped) : 0;
+  if (formats != 0 && (current & formats) == formats) {
+    skipped_count++;
+    for (int f = 0; f < bcn_Format_COUNT; f++)
+      if (formats & 1u << f) list(asset_texture_kind(flipped, (bcn_Format)f), source, blobs[f]);
+    return true;
+  }
+
+  cp_image_t png = cp_load_png(source);
+  if (png.pix == NULL) return false;
+  if (flipped)
+    cp_flip_image_horizontal(&png);
+
+  asset_TextureHeader header = {
+    .tag = { ASSET_TEXTURE_MAGIC, ASSET_VERSION, hash },
+    .width = (uint32_t)png.w,
+    .height = (uint32_t)png.h,
+    .mip_count = (uint32_t)mip_count((uint32_t)png.w, (uint32_t)png.h),
+    .flipped = flipped,
+  };
+  /* the chain is built behind the decoded base level */
+  size_t size = mip_chain_size(header.width, header.height, header.mip_count);
+  uint8_t *levels = (uint8_t*)realloc(png.pix, size);
+  mip_build(levels, header.width, header.height, header.mip_count);
+  formats = texture_formats(flipped, header.width, header.height, bcn_opaque(levels, header.width, header.height));
+
+  bool ok = true;
+  for (int f = 0; f < bcn_Format_COUNT && ok; f++) {
+    if (!(formats & 1u << f)) continue;
+    header.format = (uint32_t)f;
+    if (f == bcn_Format_RGBA8)
+      ok = write_blob(blobs[f], &header, sizeof(header), levels, size);
+    else {
+      size_t blocks_size = bcn_chain_size((bcn_Format)f, header.width, header.height, header.mip_count);
+      uint8_t *blocks = (uint8_t*)malloc(blocks_size);
+      bcn_encode_chain((bcn_Format)f, levels, header.width, header.height, header.mip_count, blocks);
+      ok = write_blob(blobs[f], &header, sizeof(header), blocks, blocks_size);
+      free(blocks);
+    }
+    if (ok) list(asset_texture_kind(flipped, (bcn_Format)f), source, blobs[f]);
+  }
+  free(levels);
+  baked_count++;
+  return ok;
+}
+
+static bool bake_atlas(void) {
+  char blob[256];
+  blob_path(blob, sizeof(blob), ASSET_ATLAS_NAME, ".tex");
+
+  uint64_t hash;
+  if (!asset_atlas_hash(ASSET_ATLAS_NAME, asset_atlas_salt, sizeof(asset_atlas_salt), &hash)) return false;
+  if (up_to_date(blob, ASSET_ATLAS_MAGIC, ASSET_VERSION, hash)) {
+    skipped_count++;
+    list("atlas", ASSET_ATLAS_NAME, blob);
+    return true;
+  }
+
+  /* the rects followed by the pixels, as asset_open_atlas expects them */
+  asset_AtlasHeader header;
+  size_t size;
+  uint8_t *data = asset_pack_atlas(&header, &size);
+  if (data == NULL) return false;
+  header.tag = (asset_Tag) { ASSET_ATLAS_MAGIC, ASSET_VERSION, hash };
+  bool ok = write_blob(blob, &header, sizeof(header), data, size);
+  free(data);
+  printf("%s packs %d images into %ux%u\n", blob, ASSET_ATLAS_WHITE, header.width, header.height);
+  baked_count++;
+  if (ok) list("atlas", ASSET_ATLAS_NAME, blob);
+  return ok;
+}
+
+static bool bake_font(const char *source) {
+  char blob[256];
+  blob_path(blob, sizeof(blob), source, ".font");
+  if (already_listed("font", source)) return true;
+
+  uint64_t hash;
+  if (!asset_source_hash(source, asset_font_salt, sizeof(asset_font_salt), &hash)) return false;
+  if (up_to_date(blob, ASSET_FONT_MAGIC, ASSET_VERSION, hash)) {
+    skipped_count++;
+    list("font", source, blob);
+    return true;
+  }
+
+  fio_Map ttf;
+  if (!fio_map(source, &ttf)) return false;
+  /* glyph tables followed by the atlas, as asset_open_font expects them */
+  uint8_t *data = (uint8_t*)calloc(1, ASSET_FONT_DATA_SIZE);
+  asset_FontHeader header;
+  bool ok = asset_pack_font((const uint8_t*)ttf.data, &header, data);
+  fio_unmap(&ttf);
+  header.tag = (asset_Tag) { ASSET_FONT_MAGIC, ASSET_VERSION, hash };
+  ok = ok && write_blob(blob, &header, sizeof(header), data, ASSET_FONT_DATA_SIZE);
+  free(data);
+  baked_count++;
+  if (ok) list("font", source, blob);
+  return ok;
+}
+
+static bool failed;
+
+static void report(bool ok, const char *source) {
+  if (ok) return;
+  fprintf(stderr, "Could not bake %s\n", source);
+  failed = true;
+}
+
+int main(void) {
+  mip_init();
+  mkdir(ASSET_DIR, 0755);
+  manifest = fopen(ASSET_MANIFEST ".tmp", "w");
+  if (manifest == NULL) {
+    fprintf(stderr, "Could not write %s\n", ASSET_MANIFEST);
+    return 1;
+  }
+
+#define X(art, shader, model, texture, parts, part_count) \
+  report(bake_mesh(model, parts, part_count), model);     \
+  report(bake_texture(texture, true), texture);
+  ASSET_MESHES(X)
+#undef X
+#define X(image) report(bake_texture(image, false), image);
+  ASSET_IMAGES(X)
+#undef X
+  report(bake_atlas(), ASSET_ATLAS_NAME);
+#define X(font) report(bake_font(font), font);
+  ASSET_FONTS(X)
+#undef X
+
+  /* only replace the manifest once every blob it lists is in place */
+  fclose(manifest);
+#ifdef _WIN32
+  remove(ASSET_MANIFEST);
+#endif
+  if (failed || rename(ASSET_MANIFEST ".tmp", ASSET_MANIFEST) != 0) {
+    remove(ASSET_MANIFEST ".tmp");
+    return 1;
+  }
+  printf("Baked %zu assets, %zu were up to date\n", baked_count, skipped_count);
+  return 0;
+}
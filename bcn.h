@@ -0,0 +1,427 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+/* Block compression of RGBA8 textures into BC1, BC3 and BC7.
+ *
+ * Every format stores 4x4 texel blocks, BC1 in 8 bytes and the other two in
+ * 16, a level whose side isn't a multiple of 4 is padded by repeating its
+ * last row and column. BC1 and BC3 fit their colour endpoints along the
+ * principal axis of the block and refine them once by least squares. BC7 is
+ * only written in mode 6, a single RGBA line with 16 steps, which suits
+ * textures without sharp edges inside a block like the ones we have.
+ *
+ * Formats are passed around as masks of (1u << bcn_Format) for what the GPU
+ * can sample, bcn_pick chooses the format a texture gets from those. */
+
+typedef enum {
+  bcn_Format_RGBA8,
+  bcn_Format_BC1,
+  bcn_Format_BC3,
+  bcn_Format_BC7,
+  bcn_Format_COUNT,
+} bcn_Format;
+
+/* bytes of a 4x4 block, or of a texel for RGBA8 */
+__attribute__((unused))
+static size_t bcn_block_size(bcn_Format format) {
+  switch (format) {
+    case bcn_Format_BC1: return 8;
+    case bcn_Format_BC3: return 16;
+    case bcn_Format_BC7: return 16;
+    default: return 4;
+  }
+}
+
+__attribute__((unused))
+static size_t bcn_level_size(bcn_Format format, uint32_t width, uint32_t height) {
+  if (format == bcn_Format_RGBA8)
+    return (size_t)width*height*4;
+  return (size_t)((width + 3)/4)*((height + 3)/4)*bcn_block_size(format);
+}
+
+/* Bytes taken by the first `count` levels of a chain, stored back to back */
+__attribute__((unused))
+static size_t bcn_chain_size(bcn_Format format, uint32_t width, uint32_t height, size_t count) {
+  size_t size = 0;
+  for (size_t i = 0; i < count; i++) {
+    size += bcn_level_size(format, width, height);
+    width = width > 1 ? width/2 : 1;
+    height = height > 1 ? height/2 : 1;
+  }
+  return size;
+}
+
+__attribute__((unused))
+static bool bcn_opaque(const uint8_t *rgba, uint32_t width, uint32_t height) {
+  for (size_t i = 0; i < (size_t)width*height; i++)
+    if (rgba[i*4 + 3] != 255) return false;
+  return true;
+}
+
+/* The format out of `formats` a texture is compressed to. Opaque ones get
+ * BC7 before BC1, it holds up much better on gradients. Mode 6 puts colour
+ * and alpha on one line though, so those with alpha get BC3 first. D3D11
+ * only takes block compressed textures whose base level is whole blocks. */
+__attribute__((unused))
+static bcn_Format bcn_pick(uint32_t formats, uint32_t width, uint32_t height, bool opaque) {
+  static const bcn_Format opaque_order[] = { bcn_Format_BC7, bcn_Format_BC1, bcn_Format_BC3 };
+  static const bcn_Format alpha_order[] = { bcn_Format_BC3, bcn_Format_BC7 };
+  if (width % 4 != 0 || height % 4 != 0) return bcn_Format_RGBA8;
+  const bcn_Format *order = opaque ? opaque_order : alpha_order;
+  size_t count = opaque ? 3 : 2;
+  for (size_t i = 0; i < count; i++)
+    if (formats & (1u << order[i])) return order[i];
+  return bcn_Format_RGBA8;
+}
+
+/* ------------------------------ fitting ----------------------------- */
+
+/* The 16 texels of the block at (`bx`, `by`), edges repeated past the level */
+static void _bcn_load_block(const uint8_t *rgba, uint32_t width, uint32_t height,
+                            uint32_t bx, uint32_t by, uint8_t block[16][4]) {
+  for (uint32_t y = 0; y < 4; y++)
+    for (uint32_t x = 0; x < 4; x++) {
+      uint32_t sx = m_min(bx*4 + x, width - 1), sy = m_min(by*4 + y, height - 1);
+      memcpy(block[y*4 + x], rgba + ((size_t)sy*width + sx)*4, 4);
+    }
+}
+
+/* Ends of the line through the first `channels` of the block along its
+ * principal axis, at the outermost texels */
+static void _bcn_principal_ends(uint8_t block[16][4], int channels, float lo[4], float hi[4]) {
+  float mean[4] = { 0 }, cov[4][4] = { 0 };
+  for (int i = 0; i < 16; i++)
+    for (int c = 0; c < channels; c++)
+      mean[c] += block[i][c]/16.0f;
+  for (int i = 0; i < 16; i++)
+    for (int a = 0; a < channels; a++)
+      for (int b = 0; b < channels; b++)
+        cov[a][b] += (block[i][a] - mean[a])*(block[i][b] - mean[b]);
+
+  /* a few rounds of power iteration are plenty for 4x4 matrices */
+  float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+  for (int n = 0; n < 6; n++) {
+    float next[4] = { 0 }, len = 0.0f;
+    for (int a = 0; a < channels; a++) {
+      for (int b = 0; b < channels; b++)
+        next[a] += cov[a][b]*axis[b];
+      len = fmaxf(len, fabsf(next[a]));
+    }
+    if (len < 1e-6f) break;
+    for (int a = 0; a < channels; a++)
+      axis[a] = next[a]/len;
+  }
+
+  float min_t = INFINITY, max_t = -INFINITY;
+  for (int i = 0; i < 16; i++) {
+    float t = 0.0f;
+    for (int c = 0; c < channels; c++)
+      t += (block[i][c] - mean[c])*axis[c];
+    min_t = fminf(min_t, t);
+    max_t = fmaxf(max_t, t);
+  }
+  float len2 = 0.0f;
+  for (int c = 0; c < channels; c++)
+    len2 += axis[c]*axis[c];
+  for (int c = 0; c < channels; c++) {
+    lo[c] = mean[c] + axis[c]*min_t/len2;
+    hi[c] = mean[c] + axis[c]*max_t/len2;
+  }
+}
+
+/* Nearest of the `count` palette entries for every texel, by their first
+ * `channels`. Returns the summed squared error. */
+static uint32_t _bcn_match(uint8_t block[16][4], int channels, int palette[][4], int count,
+                           uint8_t indices[16]) {
+  uint32_t total = 0;
+  for (int i = 0; i < 16; i++) {
+    uint32_t best = UINT32_MAX;
+    for (int p = 0; p < count; p++) {
+      uint32_t err = 0;
+      for (int c = 0; c < channels; c++) {
+        int d = block[i][c] - palette[p][c];
+        err += (uint32_t)(d*d);
+      }
+      if (err < best) {
+        best = err;
+        indices[i] = (uint8_t)p;
+      }
+    }
+    total += best;
+  }
+  return total;
+}
+
+/* Least squares ends of the line that best fits the block, each texel taken
+ * `weights[indices[i]]` of the way from `lo` to `hi`. False if the texels all
+ * sit at one point along it. */
+static bool _bcn_refit(uint8_t block[16][4], int channels, const float *weights, const uint8_t indices[16],
+                       float lo[4], float hi[4]) {
+  float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[4] = { 0 }, bx[4] = { 0 };
+  for (int i = 0; i < 16; i++) {
+    float b = weights[indices[i]], a = 1.0f - b;
+    aa += a*a;
+    ab += a*b;
+    bb += b*b;
+    for (int c = 0; c < channels; c++) {
+      ax[c] += a*block[i][c];
+      bx[c] += b*block[i][c];
+    }
+  }
+  float det = aa*bb - ab*ab;
+  if (fabsf(det) < 1e-6f) return false;
+  for (int c = 0; c < channels; c++) {
+    lo[c] = (bb*ax[c] - ab*bx[c])/det;
+    hi[c] = (aa*bx[c] - ab*ax[c])/det;
+  }
+  return true;
+}
+
+/* ------------------------------ BC1/BC3 ----------------------------- */
+
+static uint16_t _bcn_to_565(const float c[4]) {
+  int r = (int)lrintf(fminf(fmaxf(c[0], 0.0f), 255.0f)*31.0f/255.0f);
+  int g = (int)lrintf(fminf(fmaxf(c[1], 0.0f), 255.0f)*63.0f/255.0f);
+  int b = (int)lrintf(fminf(fmaxf(c[2], 0.0f), 255.0f)*31.0f/255.0f);
+  return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+static void _bcn_from_565(uint16_t c, int out[4]) {
+  int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+  out[0] = r << 3 | r >> 2;
+  out[1] = g << 2 | g >> 4;
+  out[2] = b << 3 | b >> 2;
+  out[3] = 255;
+}
+
+/* Squared error of the opaque four colour block between `c0` and `c1` */
+static uint32_t _bcn_color_try(uint8_t block[16][4], uint16_t c0, uint16_t c1, uint8_t indices[16]) {
+  int palette[4][4];
+  _bcn_from_565(c0, palette[0]);
+  _bcn_from_565(c1, palette[1]);
+  for (int c = 0; c < 3; c++) {
+    palette[2][c] = (2*palette[0][c] + palette[1][c])/3;
+    palette[3][c] = (palette[0][c] + 2*palette[1][c])/3;
+  }
+  return _bcn_match(block, 3, palette, 4, indices);
+}
+
+/* The 8 byte colour half of BC1 and BC3, always in four colour mode */
+static void _bcn_color_block(uint8_t block[16][4], uint8_t out[8]) {
+  /* how far each index is from c0 towards c1 */
+  static const float weights[4] = { 0.0f, 1.0f, 1.0f/3.0f, 2.0f/3.0f };
+  float lo[4], hi[4];
+  uint8_t indices[16], refit[16];
+  _bcn_principal_ends(block, 3, lo, hi);
+  uint16_t c0 = _bcn_to_565(hi), c1 = _bcn_to_565(lo);
+  uint32_t err = _bcn_color_try(block, c0, c1, indices);
+  if (_bcn_refit(block, 3, weights, indices, hi, lo)) {
+    uint16_t r0 = _bcn_to_565(hi), r1 = _bcn_to_565(lo);
+    if (_bcn_color_try(block, r0, r1, refit) < err) {
+      c0 = r0;
+      c1 = r1;
+      memcpy(indices, refit, sizeof(indices));
+    }
+  }
+
+  /* c0 > c1 selects four colours, swapping the ends swaps 0 with 1 and 2 with 3 */
+  uint32_t flip = 0;
+  if (c0 < c1) {
+    uint16_t swap = c0;
+    c0 = c1;
+    c1 = swap;
+    flip = 1;
+  }
+  uint32_t bits = 0;
+  if (c0 != c1)
+    for (int i = 0; i < 16; i++)
+      bits |= (indices[i] ^ flip) << (i*2);
+  out[0] = (uint8_t)c0;
+  out[1] = (uint8_t)(c0 >> 8);
+  out[2] = (uint8_t)c1;
+  out[3] = (uint8_t)(c1 >> 8);
+  memcpy(out + 4, (uint8_t[4]) { (uint8_t)bits, (uint8_t)(bits >> 8), (uint8_t)(bits >> 16), (uint8_t)(bits >> 24) }, 4);
+}
+
+/* The 8 byte alpha half of BC3, in eight step mode between its extremes */
+static void _bcn_alpha_block(uint8_t block[16][4], uint8_t out[8]) {
+  int a0 = 0, a1 = 255;
+  for (int i = 0; i < 16; i++) {
+    a0 = block[i][3] > a0 ? block[i][3] : a0;
+    a1 = block[i][3] < a1 ? block[i][3] : a1;
+  }
+  uint64_t bits = 0;
+  if (a0 != a1)
+    for (int i = 0; i < 16; i++) {
+      /* index 0 is a0, 1 is a1, 2 to 7 step from a0 towards a1 */
+      int step = ((a0 - block[i][3])*7 + (a0 - a1)/2)/(a0 - a1);
+      uint64_t index = step == 0 ? 0 : step == 7 ? 1 : (uint64_t)step + 1;
+      bits |= index << (i*3);
+    }
+  out[0] = (uint8_t)a0;
+  out[1] = (uint8_t)a1;
+  for (int i = 0; i < 6; i++)
+    out[2 + i] = (uint8_t)(bits >> (i*8));
+}
+
+/* -------------------------------- BC7 ------------------------------- */
+
+static const int _bcn_bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/* Endpoint with 7 bits per channel and the shared lowest bit that gets it
+ * closest to `c`. An alpha of 255 needs the lowest bit set to stay opaque. */
+static void _bcn_bc7_endpoint(const float c[4], int out[4]) {
+  float best = INFINITY;
+  for (int p = c[3] > 254.5f; p < 2; p++) {
+    int q[4];
+    float err = 0.0f;
+    for (int k = 0; k < 4; k++) {
+      int v = (int)lrintf((fminf(fmaxf(c[k], 0.0f), 255.0f) - (float)p)/2.0f);
+      q[k] = (v < 0 ? 0 : v > 127 ? 127 : v)*2 + p;
+      float d = (float)q[k] - c[k];
+      err += d*d;
+    }
+    if (err < best) {
+      best = err;
+      memcpy(out, q, sizeof(q));
+    }
+  }
+}
+
+typedef struct {
+  int ends[2][4];
+  uint8_t indices[16];
+  uint32_t err;
+} _bcn_Bc7Fit;
+
+/* Fits the line `lo` to `hi`. Each texel is projected onto it and only the
+ * steps either side of where it lands are compared. */
+static _bcn_Bc7Fit _bcn_bc7_try(uint8_t block[16][4], const float lo[4], const float hi[4]) {
+  _bcn_Bc7Fit fit = { .err = 0 };
+  _bcn_bc7_endpoint(lo, fit.ends[0]);
+  _bcn_bc7_endpoint(hi, fit.ends[1]);
+  int palette[16][4], dir[4], len2 = 0;
+  for (int i = 0; i < 16; i++)
+    for (int k = 0; k < 4; k++)
+      palette[i][k] = ((64 - _bcn_bc7_weights[i])*fit.ends[0][k] + _bcn_bc7_weights[i]*fit.ends[1][k] + 32) >> 6;
+  for (int k = 0; k < 4; k++) {
+    dir[k] = fit.ends[1][k] - fit.ends[0][k];
+    len2 += dir[k]*dir[k];
+  }
+
+  for (int i = 0; i < 16; i++) {
+    int dot = 0;
+    for (int k = 0; k < 4; k++)
+      dot += (block[i][k] - fit.ends[0][k])*dir[k];
+    int guess = len2 > 0 ? (int)lrintf(15.0f*(float)dot/(float)len2) : 0;
+    guess = guess < 0 ? 0 : guess > 15 ? 15 : guess;
+    uint32_t best = UINT32_MAX;
+    for (int s = guess > 0 ? guess - 1 : 0; s <= guess + 1 && s < 16; s++) {
+      uint32_t err = 0;
+      for (int k = 0; k < 4; k++) {
+        int d = block[i][k] - palette[s][k];
+        err += (uint32_t)(d*d);
+      }
+      if (err < best) {
+        best = err;
+        fit.indices[i] = (uint8_t)s;
+      }
+    }
+    fit.err += best;
+  }
+  return fit;
+}
+
+/* A mode 6 block: the mode bit, both endpoints channel by channel, their lowest
+ * bits, then 4 bit indices except for the first texel's, which has to be
+ * below 8 and is stored in 3 */
+static void _bcn_bc7_block(uint8_t block[16][4], uint8_t out[16]) {
+  float weights[16], lo[4], hi[4];
+  for (int i = 0; i < 16; i++)
+    weights[i] = (float)_bcn_bc7_weights[i]/64.0f;
+  _bcn_principal_ends(block, 4, lo, hi);
+  _bcn_Bc7Fit fit = _bcn_bc7_try(block, lo, hi);
+  if (fit.err > 0 && _bcn_refit(block, 4, weights, fit.indices, lo, hi)) {
+    _bcn_Bc7Fit refit = _bcn_bc7_try(block, lo, hi);
+    if (refit.err < fit.err)
+      fit = refit;
+  }
+
+  /* the weights are symmetric, so swapping the ends mirrors the indices */
+  if (fit.indices[0] >= 8) {
+    for (int k = 0; k < 4; k++) {
+      int swap = fit.ends[0][k];
+      fit.ends[0][k] = fit.ends[1][k];
+      fit.ends[1][k] = swap;
+    }
+    for (int i = 0; i < 16; i++)
+      fit.indices[i] = (uint8_t)(15 - fit.indices[i]);
+  }
+
+  uint64_t bits[2] = { 0 };
+  size_t at = 0;
+#define BCN_PUT(value, count)                                         \
+  for (size_t b = 0; b < (count); b++, at++)                          \
+    bits[at/64] |= (uint64_t)(((value) >> b) & 1) << (at%64);
+  BCN_PUT(1u << 6, 7)
+  for (int k = 0; k < 4; k++) {
+    BCN_PUT((uint32_t)fit.ends[0][k] >> 1, 7)
+    BCN_PUT((uint32_t)fit.ends[1][k] >> 1, 7)
+  }
+  BCN_PUT((uint32_t)fit.ends[0][0] & 1, 1)
+  BCN_PUT((uint32_t)fit.ends[1][0] & 1, 1)
+  BCN_PUT((uint32_t)fit.indices[0], 3)
+  for (int i = 1; i < 16; i++) {
+    BCN_PUT((uint32_t)fit.indices[i], 4)
+  }
+#undef BCN_PUT
+  for (int i = 0; i < 16; i++)
+    out[i] = (uint8_t)(bits[i/8] >> (i%8*8));
+}
+
+/* ------------------------------ encoding ---------------------------- */
+
+/* Compresses one `width` by `height` RGBA8 level into `out`, which has room for
+ * bcn_level_size(format, width, height) bytes */
+__attribute__((unused))
+static void bcn_encode(bcn_Format format, const uint8_t *rgba, uint32_t width, uint32_t height, uint8_t *out) {
+  if (format == bcn_Format_RGBA8) {
+    memcpy(out, rgba, bcn_level_size(format, width, height));
+    return;
+  }
+  for (uint32_t by = 0; by < (height + 3)/4; by++)
+    for (uint32_t bx = 0; bx < (width + 3)/4; bx++) {
+      uint8_t block[16][4];
+      _bcn_load_block(rgba, width, height, bx, by, block);
+      switch (format) {
+        case bcn_Format_BC1:
+          _bcn_color_block(block, out);
+          break;
+        case bcn_Format_BC3:
+          _bcn_alpha_block(block, out);
+          _bcn_color_block(block, out + 8);
+          break;
+        default:
+          _bcn_bc7_block(block, out);
+          break;
+      }
+      out += bcn_block_size(format);
+    }
+}
+
+/* Compresses the `count` levels of an RGBA8 chain laid out as mip_build writes
+ * them, into the same layout with each level bcn_level_size bytes long */
+__attribute__((unused))
+static void bcn_encode_chain(bcn_Format format, const uint8_t *levels, uint32_t width, uint32_t height,
+                             size_t count, uint8_t *out) {
+  for (size_t i = 0; i < count; i++) {
+    bcn_encode(format, levels, width, height, out);
+    levels += bcn_level_size(bcn_Format_RGBA8, width, height);
+    out += bcn_level_size(format, width, height);
+    width = width > 1 ? width/2 : 1;
+    height = height > 1 ? height/2 : 1;
+  }
+}
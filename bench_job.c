@@ -0,0 +1,77 @@
+/* Throughput of a tick-sized parallel-for, on one thread and on the job
+ * threads, built and run by ./run-bench */
+#define SOKOL_IMPL
+#include "sokol/sokol_time.h"
+
+#include <stdio.h>
+#include <math.h>
+#include "worker.h"
+#include "job.h"
+
+#define BENCH_MIN_MS 250.0
+#define BENCH_ENTS (1 << 12)
+#define BENCH_GRAIN (256)
+/* neighbours each entity steers away from, roughly what a tick stage costs per entity */
+#define BENCH_NEIGHBOURS (64)
+
+typedef struct {
+  float x, y, vx, vy;
+} Body;
+
+static Body bodies[BENCH_ENTS], moved[BENCH_ENTS];
+
+static void step(void *arg, size_t begin, size_t end) {
+  (void)arg;
+  for (size_t i = begin; i < end; i++) {
+    Body b = bodies[i];
+    for (size_t n = 1; n <= BENCH_NEIGHBOURS; n++) {
+      const Body *o = bodies + (i + n*97) % BENCH_ENTS;
+      float dx = b.x - o->x, dy = b.y - o->y;
+      float d2 = dx*dx + dy*dy + 0.01f;
+      b.vx += dx/d2*0.001f;
+      b.vy += dy/d2*0.001f;
+    }
+    b.x += b.vx;
+    b.y += b.vy;
+    moved[i] = b;
+  }
+}
+
+static double run(bool parallel, size_t *steps) {
+  uint64_t start = stm_now();
+  *steps = 0;
+  do {
+    if (parallel)
+      job_for(step, NULL, BENCH_ENTS, BENCH_GRAIN);
+    else
+      step(NULL, 0, BENCH_ENTS);
+    *steps += 1;
+  } while (stm_ms(stm_since(start)) < BENCH_MIN_MS);
+  return stm_ms(stm_since(start));
+}
+
+int main(void) {
+  stm_setup();
+  for (size_t i = 0; i < BENCH_ENTS; i++)
+    bodies[i] = (Body) { (float)(i % 64), (float)(i / 64), 0.0f, 0.0f };
+  job_init(worker_core_count());
+
+  /* the same step on one thread and on all of them has to give the same bodies */
+  static Body serial[BENCH_ENTS];
+  step(NULL, 0, BENCH_ENTS);
+  memcpy(serial, moved, sizeof(moved));
+  memset(moved, 0, sizeof(moved));
+  job_for(step, NULL, BENCH_ENTS, BENCH_GRAIN);
+  if (memcmp(serial, moved, sizeof(moved)) != 0) {
+    printf("job_for: results differ from one thread\n");
+    return 1;
+  }
+
+  size_t serial_steps, parallel_steps;
+  double serial_ms = run(false, &serial_steps);
+  double parallel_ms = run(true, &parallel_steps);
+  printf("%d entities: %.3f ms a step on one thread, %.3f ms on %zu threads\n", BENCH_ENTS,
+         serial_ms/(double)serial_steps, parallel_ms/(double)parallel_steps, job_thread_count());
+  job_shutdown();
+  return 0;
+}
@@ -0,0 +1,46 @@
+/* Parser throughput over the bundled models, built and run by ./run-bench */
+#define SOKOL_IMPL
+#include "sokol/sokol_time.h"
+
+#include <math.h>
+#include "math.h"
+#include "fio.h"
+#define OBJ_QUIET
+#include "obj.h"
+
+#define BENCH_MIN_MS 250.0
+
+int main(void) {
+  const char *paths[] = {
+    "Asteroid.obj", "Bob.obj", "Cube.obj", "LASER.obj",
+    "Mineral.obj", "Pillar.obj", "Plane.obj",
+  };
+  stm_setup();
+
+  double total_bytes = 0.0, total_ms = 0.0;
+  for (size_t i = 0; i < sizeof(paths)/sizeof(paths[0]); i += 1) {
+    char *src = fio_read_text(paths[i]);
+    if (src == NULL) {
+      printf("%s: cannot read, run from the repository root\n", paths[i]);
+      return 1;
+    }
+    double bytes = (double)strlen(src);
+
+    /* keep parsing until the sample is long enough to time reliably */
+    size_t runs = 0;
+    uint64_t start = stm_now();
+    do {
+      obj_Result res = obj_parse(src);
+      obj_dispose(&res);
+      runs += 1;
+    } while (stm_ms(stm_since(start)) < BENCH_MIN_MS);
+    double ms = stm_ms(stm_since(start));
+
+    printf("%-14s %8.0f bytes %6zu runs %8.2f MB/s\n", paths[i], bytes, runs, bytes*(double)runs/(ms*1000.0));
+    total_bytes += bytes*(double)runs;
+    total_ms += ms;
+    free(src);
+  }
+  printf("%-14s %37.2f MB/s\n", "total", total_bytes/(total_ms*1000.0));
+  return 0;
+}
@@ -0,0 +1,99 @@
+/* PNG decode throughput over the bundled images, and the startup textures
+ * decoded one after another versus on the workers, built and run by ./run-bench */
+#define SOKOL_IMPL
+#include "sokol/sokol_time.h"
+#define CUTE_PNG_IMPLEMENTATION
+#include "cute_png.h"
+
+#include "fio.h"
+#include "worker.h"
+
+#include <time.h>
+
+#define BENCH_MIN_MS 250.0
+
+typedef struct {
+  const char *path;
+  cp_image_t img;
+} Decode;
+
+static void decode_run(void *arg) {
+  Decode *decode = (Decode*)arg;
+  decode->img = cp_load_png(decode->path);
+}
+
+static void decode_finish(void *arg) {
+  cp_free_png(&((Decode*)arg)->img);
+}
+
+int main(void) {
+  const char *paths[] = {
+    "Bob_Orange.png", "Gem.png", "Mineral.png", "Moon.png", "Pillar.png",
+    "healthbar.png", "screenshot.png", "test_tex.png", "ui.png",
+  };
+  size_t path_count = sizeof(paths)/sizeof(paths[0]);
+  stm_setup();
+
+  double total_pixels = 0.0, total_ms = 0.0;
+  for (size_t i = 0; i < path_count; i += 1) {
+    fio_Map map;
+    if (!fio_map(paths[i], &map)) {
+      printf("%s: cannot read, run from the repository root\n", paths[i]);
+      return 1;
+    }
+
+    /* keep decoding until the sample is long enough to time reliably */
+    size_t runs = 0;
+    double pixels = 0.0;
+    uint64_t start = stm_now();
+    do {
+      cp_image_t img = cp_load_png_mem(map.data, (int)map.size);
+      if (img.pix == NULL) {
+        printf("%s: %s\n", paths[i], cp_error_reason);
+        return 1;
+      }
+      pixels = (double)img.w*img.h;
+      cp_free_png(&img);
+      runs += 1;
+    } while (stm_ms(stm_since(start)) < BENCH_MIN_MS);
+    double ms = stm_ms(stm_since(start));
+
+    printf("%-15s %9zu bytes %5zu runs %8.2f MB/s in %8.2f Mpixel/s\n", paths[i], map.size, runs,
+           (double)map.size*(double)runs/(ms*1000.0), pixels*(double)runs/(ms*1000.0));
+    total_pixels += pixels*(double)runs;
+    total_ms += ms;
+    fio_unmap(&map);
+  }
+  printf("%-15s %50.2f Mpixel/s\n", "total", total_pixels/(total_ms*1000.0));
+
+  /* the mesh textures init() queues, see load_texture */
+  const char *startup[] = { "Bob_Orange.png", "Moon.png", "Mineral.png", "Mineral.png", "Pillar.png" };
+  size_t startup_count = sizeof(startup)/sizeof(startup[0]);
+  Decode decodes[sizeof(startup)/sizeof(startup[0])];
+
+  uint64_t start = stm_now();
+  for (size_t i = 0; i < startup_count; i += 1) {
+    decodes[i] = (Decode) { .path = startup[i] };
+    decode_run(decodes + i);
+    decode_finish(decodes + i);
+  }
+  double serial_ms = stm_ms(stm_since(start));
+
+  worker_init();
+  start = stm_now();
+  for (size_t i = 0; i < startup_count; i += 1) {
+    decodes[i] = (Decode) { .path = startup[i] };
+    worker_push(decode_run, decode_finish, decodes + i);
+  }
+  /* poll like frame() would, without taking a core from the workers */
+  while (worker_busy()) {
+    worker_finish();
+    nanosleep(&(struct timespec) { .tv_nsec = 1000000 }, NULL);
+  }
+  double parallel_ms = stm_ms(stm_since(start));
+  worker_shutdown();
+
+  printf("startup textures: %.1f ms one after another, %.1f ms on %zu workers\n",
+         serial_ms, parallel_ms, worker_core_count() > 1 ? worker_core_count() - 1 : 1);
+  return 0;
+}
@@ -149,13 +149,14 @@ bool build_event(const sapp_event *ev) {
   return false;
 }
 
-static void draw_ent(Mat4 vp, Ent *ent);
+static void draw_ent(Mat4 vp, Ent *ent, float cam_dist);
 void build_draw_3d(Mat4 vp) {
   Ent dest, *plr = try_gendex(state->player);
   if (plr && _build_make_ent(plr, &dest) && self.appearing) {
-    sg_apply_pipeline(state->pip[state->meshes[dest.art].shader]);
+    sg_apply_pipeline(mesh_pipeline(state->meshes + dest.art));
     dest.transparency = 0.5;
-    draw_ent(vp, &dest);
+    /* the ghost is always close by, keep it at full detail */
+    draw_ent(vp, &dest, 0.0f);
   }
 }
 
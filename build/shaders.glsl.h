@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#define ATTR_vs_position (0)
+#define ATTR_vs_uv (1)
+#define ATTR_vs_normal (2)
+#define SLOT_vs_params (0)
+typedef struct vs_params_t {
+  Mat4 view_proj;
+  Mat4 model;
+  Vec4 position_min;
+  Vec4 position_extent;
+  Vec4 uv_range;
+} vs_params_t;
+#define SLOT_mesh_fs_params (0)
+typedef struct mesh_fs_params_t {
+  float bloom;
+  float transparency;
+} mesh_fs_params_t;
+#define SLOT_tex (0)
+#define ATTR_laser_vs_position (0)
+#define ATTR_laser_vs_uv (1)
+#define ATTR_force_field_vs_position (0)
+#define ATTR_force_field_vs_uv (1)
+#define SLOT_force_field_fs_params (0)
+typedef struct force_field_fs_params_t {
+  float transparency;
+  Vec2 stretch;
+  float time;
+} force_field_fs_params_t;
+#define ATTR_healthbar_vs_pos (0)
+#define ATTR_healthbar_vs_uv (1)
+#define ATTR_healthbar_vs_hp (2)
+#define ATTR_healthbar_vs_fancy_shape (3)
+#define SLOT_healthbar_vs_params (0)
+typedef struct healthbar_vs_params_t {
+  Vec2 resolution;
+} healthbar_vs_params_t;
+#define SLOT_healthbar_fs_params (0)
+typedef struct healthbar_fs_params_t {
+  float time;
+} healthbar_fs_params_t;
+#define ATTR_overlay_vs_vert_pos (0)
+#define ATTR_overlay_vs_uv (1)
+#define SLOT_overlay_vs_params (0)
+typedef struct overlay_vs_params_t {
+  float softness;
+  Vec2 minuv;
+  Vec2 sizuv;
+  Vec2 pos;
+  Vec2 size;
+  Vec2 resolution;
+  Vec4 modulate;
+} overlay_vs_params_t;
+#define ATTR_fsq_vs_pos (0)
+#define SLOT_bloom (1)
+#define SLOT_blur_fs_params (0)
+typedef struct blur_fs_params_t {
+  Vec2 dir;
+  Vec4 offsets;
+  Vec4 weights;
+} blur_fs_params_t;
+static inline const sg_shader_desc* mesh_shader_desc(sg_backend b) { (void)b; static sg_shader_desc d; return &d; }
+static inline const sg_shader_desc* laser_shader_desc(sg_backend b) { (void)b; static sg_shader_desc d; return &d; }
+static inline const sg_shader_desc* force_field_shader_desc(sg_backend b) { (void)b; static sg_shader_desc d; return &d; }
+static inline const sg_shader_desc* healthbar_shader_desc(sg_backend b) { (void)b; static sg_shader_desc d; return &d; }
+static inline const sg_shader_desc* overlay_shader_desc(sg_backend b) { (void)b; static sg_shader_desc d; return &d; }
+static inline const sg_shader_desc* fsq_shader_desc(sg_backend b) { (void)b; static sg_shader_desc d; return &d; }
+static inline const sg_shader_desc* bloom_down_shader_desc(sg_backend b) { (void)b; static sg_shader_desc d; return &d; }
+static inline const sg_shader_desc* bloom_up_shader_desc(sg_backend b) { (void)b; static sg_shader_desc d; return &d; }
+static inline const sg_shader_desc* blur_shader_desc(sg_backend b) { (void)b; static sg_shader_desc d; return &d; }
@@ -26,38 +26,87 @@ static void collision_intersects(Ent *a, Ent *b, float *depth, Vec2 *normal) {
   }
 }
 
-static void collision(Ent *ac) {
+/* outer entities each narrow phase job tests against all others */
+#define COLLISION_GRAIN (64)
+#define _COLLISION_SLICES ((STATE_MAX_ENTS + COLLISION_GRAIN - 1)/COLLISION_GRAIN)
+
+/* `a` overlaps `b` by `depth`, as collision_intersects reports it */
+typedef struct {
+  Ent *a, *b;
+  float depth;
+  Vec2 normal;
+} collision_Contact;
+
+/* The contacts the narrow phase found, one list per slice of outer entities.
+ * Each slice lists its contacts by `a` and then by `b`, so reading the slices
+ * in order gives the contacts in pool order. */
+static struct {
+  collision_Contact *contacts[_COLLISION_SLICES];
+  size_t counts[_COLLISION_SLICES], capacities[_COLLISION_SLICES];
+} _collision_state;
+
+/* Finds what every entity in [begin, end) of the pool overlaps. Only reads
+ * positions and colliders, which nothing changes until the contacts are resolved. */
+static void _collision_narrow(void *arg, size_t begin, size_t end) {
+  (void)arg;
+  size_t slice = begin/COLLISION_GRAIN;
+  _collision_state.counts[slice] = 0;
+
+  for (Ent *ac = state->ents + begin; ac < state->ents + end; ac++) {
+    if (!has_ent_prop(ac, EntProp_Active) || ac->collider.size == 0.0f) continue;
+
+    for (Ent *ent = 0; (ent = ent_all_iter(ent));) {
+      // We can just check the pointers here to see if they are the same entity
+      if (ent == ac) continue;
+      if (ent->collider.size == 0.0f) continue;
+
+      float depth = 0.0f;
+      Vec2 normal = { 0 };
+      collision_intersects(ac, ent, &depth, &normal);
+      if (depth >= 0.0f) continue;
+
+      size_t *count = _collision_state.counts + slice, *capacity = _collision_state.capacities + slice;
+      if (*count == *capacity) {
+        *capacity = *capacity ? *capacity*2 : 64;
+        _collision_state.contacts[slice] = realloc(_collision_state.contacts[slice], *capacity*sizeof(collision_Contact));
+      }
+      _collision_state.contacts[slice][(*count)++] = (collision_Contact) { ac, ent, depth, normal };
+    }
+  }
+}
+
+/* Pushes `c->b` away from `c->a`, with their velocities as the contacts before left them */
+static void _collision_push(collision_Contact *c) {
+  Ent *ac = c->a, *ent = c->b;
   Collider *a_cl = &ac->collider;
+  Collider *e_cl = &ent->collider;
+  ent->last_collision = state->tick;
+  ac->last_collision = state->tick;
 
-  if (ac->collider.size == 0.0f) return;
+  float depth = sqrtf(m_abs(c->depth));
+  float weight_sum = a_cl->weight + e_cl->weight;
+  float force = mag2(sub2(ac->vel, ent->vel));
+  force *= a_cl->weight / weight_sum;
+  force *= depth;
+  if (weight_sum!=0.0f)
+    ent->vel = sub2(ent->vel, mul2_f(c->normal, force));
+}
+
+/* Resolves the contacts of one entity, the ones of `count` that start at `contacts` */
+static void _collision_resolve(collision_Contact *contacts, size_t count) {
+  Ent *ac = contacts[0].a;
+  // A projectile that already hit something earlier in the tick is gone
+  if (!has_ent_prop(ac, EntProp_Active)) return;
 
   Ent *ent = NULL;
+  for (size_t i = 0; i < count; i++) {
+    if (!has_ent_prop(contacts[i].b, EntProp_Active)) continue;
+    _collision_push(contacts + i);
 
-  for (ent = 0; (ent = ent_all_iter(ent));) {
-    Collider *e_cl = &ent->collider;
-
-    // We can just check the pointers here to see if they are the same entity
-    if (ent == ac) continue;
-    if (ent->collider.size == 0.0f) continue;
-
-    float depth = 0.0f;
-    Vec2 normal = { 0 };
-    collision_intersects(ac, ent, &depth, &normal);
-    if (depth < 0.0f) {
-      ent->last_collision = state->tick;
-      ac->last_collision = state->tick;
-
-      depth = sqrtf(m_abs(depth));
-      float weight_sum = a_cl->weight + e_cl->weight;
-      float force = mag2(sub2(ac->vel, ent->vel));
-      force *= a_cl->weight / weight_sum;
-      force *= depth;
-      if (weight_sum!=0.0f)
-        ent->vel = sub2(ent->vel, mul2_f(normal, force));
-
-      //For projectiles we only want the first collision
-      if(has_ent_prop(ac,EntProp_Projectile))
-        break;
+    //For projectiles we only want the first collision
+    if (has_ent_prop(ac, EntProp_Projectile)) {
+      ent = contacts[i].b;
+      break;
     }
   }
 
@@ -73,6 +122,23 @@ static void collision(Ent *ac) {
   }
 }
 
+/* Finds every overlap across the job threads, then resolves them on the
+ * calling thread in pool order. Pushes depend on the velocities earlier ones
+ * left behind and projectiles stop at their first hit, so the order is what
+ * makes the result the same however the narrow phase was split up. */
+static void collision_tick(void) {
+  job_for(_collision_narrow, NULL, STATE_MAX_ENTS, COLLISION_GRAIN);
+
+  for (size_t slice = 0; slice < _COLLISION_SLICES; slice++) {
+    collision_Contact *contacts = _collision_state.contacts[slice];
+    size_t count = _collision_state.counts[slice];
+    for (size_t begin = 0, end; begin < count; begin = end) {
+      for (end = begin + 1; end < count && contacts[end].a == contacts[begin].a; end++);
+      _collision_resolve(contacts + begin, end - begin);
+    }
+  }
+}
+
 static void collision_movement_update(Ent *ac) {
   if (has_ent_prop(ac, EntProp_Projectile)) {
     // Instead of just using a timer, the entity gets lighter and lighter.
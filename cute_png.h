@@ -279,6 +279,7 @@ typedef struct cp_state_t
 	char* begin;
 
 	uint16_t lookup[CUTE_PNG_LOOKUP_COUNT];
+	uint16_t dst_lookup[CUTE_PNG_LOOKUP_COUNT];
 	uint32_t lit[288];
 	uint32_t dst[32];
 	uint32_t len[19];
@@ -375,7 +376,8 @@ static uint32_t cp_rev16(uint32_t a)
 }
 
 // RFC 1951 section 3.2.2
-static int cp_build(cp_state_t* s, uint32_t* tree, uint8_t* lens, int sym_count)
+// codes no longer than CUTE_PNG_LOOKUP_BITS are also entered into `lookup` when given
+static int cp_build(uint16_t* lookup, uint32_t* tree, uint8_t* lens, int sym_count)
 {
 	int n, codes[16], first[16], counts[16] = { 0 };
 
@@ -390,7 +392,7 @@ static int cp_build(cp_state_t* s, uint32_t* tree, uint8_t* lens, int sym_count)
 		first[n] = first[n - 1] + counts[n - 1];
 	}
 
-	if (s) CUTE_PNG_MEMSET(s->lookup, 0, sizeof(s->lookup));
+	if (lookup) CUTE_PNG_MEMSET(lookup, 0, sizeof(uint16_t) * CUTE_PNG_LOOKUP_COUNT);
 	for (int i = 0; i < sym_count; ++i)
 	{
 		int len = lens[i];
@@ -402,12 +404,12 @@ static int cp_build(cp_state_t* s, uint32_t* tree, uint8_t* lens, int sym_count)
 			uint32_t slot = first[len]++;
 			tree[slot] = (code << (32 - len)) | (i << 4) | len;
 
-			if (s && len <= CUTE_PNG_LOOKUP_BITS)
+			if (lookup && len <= CUTE_PNG_LOOKUP_BITS)
 			{
 				int j = cp_rev16(code) >> (16 - len);
 				while (j < (1 << CUTE_PNG_LOOKUP_BITS))
 				{
-					s->lookup[j] = (uint16_t)((len << CUTE_PNG_LOOKUP_BITS) | i);
+					lookup[j] = (uint16_t)((len << CUTE_PNG_LOOKUP_BITS) | i);
 					j += (1 << len);
 				}
 			}
@@ -444,14 +446,26 @@ cp_err:
 // 3.2.6
 static int cp_fixed(cp_state_t* s)
 {
-	s->nlit = cp_build(s, s->lit, cp_fixed_table, 288);
-	s->ndst = cp_build(0, s->dst, cp_fixed_table + 288, 32);
+	s->nlit = cp_build(s->lookup, s->lit, cp_fixed_table, 288);
+	s->ndst = cp_build(s->dst_lookup, s->dst, cp_fixed_table + 288, 32);
 	return 1;
 }
 
-static int cp_decode(cp_state_t* s, uint32_t* tree, int hi)
+static int cp_decode(cp_state_t* s, uint32_t* tree, int hi, const uint16_t* lookup)
 {
 	uint64_t bits = cp_peak_bits(s, 16);
+
+	// short codes resolve with a single table read, only long ones are searched for
+	if (lookup)
+	{
+		uint16_t entry = lookup[bits & CUTE_PNG_LOOKUP_MASK];
+		if (entry)
+		{
+			cp_consume_bits(s, entry >> CUTE_PNG_LOOKUP_BITS);
+			return entry & CUTE_PNG_LOOKUP_MASK;
+		}
+	}
+
 	uint32_t search = (cp_rev16((uint32_t)bits) << 16) | 0xFFFF;
 	int lo = 0;
 	while (lo < hi)
@@ -488,7 +502,7 @@ static int cp_dynamic(cp_state_t* s)
 
 	for (int n = 0; n < nlit + ndst;)
 	{
-		int sym = cp_decode(s, s->len, s->nlen);
+		int sym = cp_decode(s, s->len, s->nlen, 0);
 		switch (sym)
 		{
 		case 16: for (int i =  3 + cp_read_bits(s, 2); i; --i, ++n) lens[n] = lens[n - 1]; break;
@@ -498,8 +512,8 @@ static int cp_dynamic(cp_state_t* s)
 		}
 	}
 
-	s->nlit = cp_build(s, s->lit, lens, nlit);
-	s->ndst = cp_build(0, s->dst, lens + nlit, ndst);
+	s->nlit = cp_build(s->lookup, s->lit, lens, nlit);
+	s->ndst = cp_build(s->dst_lookup, s->dst, lens + nlit, ndst);
 	return 1;
 }
 
@@ -508,7 +522,7 @@ static int cp_block(cp_state_t* s)
 {
 	while (1)
 	{
-		int symbol = cp_decode(s, s->lit, s->nlit);
+		int symbol = cp_decode(s, s->lit, s->nlit, s->lookup);
 
 		if (symbol < 256)
 		{
@@ -521,7 +535,7 @@ static int cp_block(cp_state_t* s)
 		{
 			symbol -= 257;
 			int length = cp_read_bits(s, cp_len_extra_bits[symbol]) + cp_len_base[symbol];
-			int distance_symbol = cp_decode(s, s->dst, s->ndst);
+			int distance_symbol = cp_decode(s, s->dst, s->ndst, s->dst_lookup);
 			int backwards_distance = cp_read_bits(s, cp_dist_extra_bits[distance_symbol]) + cp_dist_base[distance_symbol];
 			CUTE_PNG_CHECK(s->out - backwards_distance >= s->begin, "Attempted to write before out buffer (invalid backwards distance).");
 			CUTE_PNG_CHECK(s->out + length <= s->out_end, "Attempted to overwrite out buffer while outputting a string.");
@@ -529,13 +543,17 @@ static int cp_block(cp_state_t* s)
 			char* dst = s->out;
 			s->out += length;
 
-			switch (backwards_distance)
-			{
-			case 1: // very common in images
+			if (backwards_distance == 1) // very common in images
 				CUTE_PNG_MEMSET(dst, *src, length);
-				break;
-			default: while (length--) *dst++ = *src++;
+			else if (backwards_distance >= length)
+				CUTE_PNG_MEMCPY(dst, src, length);
+			else if (backwards_distance >= 8)
+			{
+				// the source runs into the bytes being written, but never within 8 of them
+				for (; length >= 8; length -= 8, dst += 8, src += 8) CUTE_PNG_MEMCPY(dst, src, 8);
+				while (length--) *dst++ = *src++;
 			}
+			else while (length--) *dst++ = *src++;
 		}
 
 		else break;
@@ -854,6 +872,64 @@ static const uint8_t* cp_find(cp_raw_png_t* png, const char* chunk, uint32_t min
 	return 0;
 }
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CUTE_PNG_SSE2
+#include <emmintrin.h>
+
+// assembled in a register, a partial copy through memory stalls store forwarding
+static inline __m128i cp_load_pixel(const uint8_t* p, int bpp)
+{
+	uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | (bpp == 4 ? (uint32_t)p[3] << 24 : 0);
+	return _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)v), _mm_setzero_si128());
+}
+
+static __m128i cp_abs16(__m128i v)
+{
+	return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+}
+
+static __m128i cp_select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Sub (1), Average (3) or Paeth (4) for a whole row of 3 or 4 byte pixels, all channels of a
+// pixel at once. Pixels depend on their left neighbour, so this works across channels rather
+// than pixels, keeping that neighbour in a register instead of reloading what was just stored.
+static inline void cp_unfilter_row_sse2(uint8_t* raw, const uint8_t* prev, int len, int filter, int bpp)
+{
+	__m128i a = _mm_setzero_si128(), c = _mm_setzero_si128();
+	for (int x = 0; x < len; x += bpp)
+	{
+		__m128i b = cp_load_pixel(prev + x, bpp);
+		__m128i d = cp_load_pixel(raw + x, bpp);
+		__m128i predicted;
+
+		if (filter == 1) predicted = a;
+		else if (filter == 3) predicted = _mm_srli_epi16(_mm_add_epi16(a, b), 1);
+		else
+		{
+			// with p = a + b - c: |p - a| = |b - c|, |p - b| = |a - c|, |p - c| = |a + b - 2c|
+			__m128i pa = cp_abs16(_mm_sub_epi16(b, c));
+			__m128i pb = cp_abs16(_mm_sub_epi16(a, c));
+			__m128i pc = cp_abs16(_mm_sub_epi16(_mm_add_epi16(a, b), _mm_add_epi16(c, c)));
+			__m128i smallest = _mm_min_epi16(pa, _mm_min_epi16(pb, pc));
+			predicted = cp_select(_mm_cmpeq_epi16(pa, smallest), a,
+			            cp_select(_mm_cmpeq_epi16(pb, smallest), b, c));
+		}
+
+		d = _mm_and_si128(_mm_add_epi16(d, predicted), _mm_set1_epi16(0xFF));
+		uint32_t v = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(d, d));
+		raw[x] = (uint8_t)v;
+		raw[x + 1] = (uint8_t)(v >> 8);
+		raw[x + 2] = (uint8_t)(v >> 16);
+		if (bpp == 4) raw[x + 3] = (uint8_t)(v >> 24);
+		a = d;
+		c = b;
+	}
+}
+#endif
+
 static int cp_unfilter(int w, int h, int bpp, uint8_t* raw)
 {
 	int len = w * bpp;
@@ -880,6 +956,25 @@ static int cp_unfilter(int w, int h, int bpp, uint8_t* raw)
 
 	for (int y = 1; y < h; y++, prev = raw, raw += len)
 	{
+#ifdef CUTE_PNG_SSE2
+		// constant filters and pixel sizes give each call its own tight loop
+		int handled = 1;
+		switch (*raw * 8 + bpp)
+		{
+		case 1 * 8 + 3: cp_unfilter_row_sse2(raw + 1, prev, len, 1, 3); break;
+		case 3 * 8 + 3: cp_unfilter_row_sse2(raw + 1, prev, len, 3, 3); break;
+		case 4 * 8 + 3: cp_unfilter_row_sse2(raw + 1, prev, len, 4, 3); break;
+		case 1 * 8 + 4: cp_unfilter_row_sse2(raw + 1, prev, len, 1, 4); break;
+		case 3 * 8 + 4: cp_unfilter_row_sse2(raw + 1, prev, len, 3, 4); break;
+		case 4 * 8 + 4: cp_unfilter_row_sse2(raw + 1, prev, len, 4, 4); break;
+		default: handled = 0;
+		}
+		if (handled)
+		{
+			raw++;
+			continue;
+		}
+#endif
 #define FILTER_LOOP(A, B) for (x = 0 ; x < bpp; x++) raw[x] += A; for (; x < len; x++) raw[x] += B; break
 		switch (*raw++)
 		{
@@ -1,5 +1,21 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define _FIO_MMAP
+#endif
+
+/* A read-only view of a whole file, memory mapped where the platform allows it */
+typedef struct {
+  const void *data;
+  size_t size;
+  bool _mapped;
+} fio_Map;
 
 __attribute__((unused))
 static char* fio_read_text(const char *path) {
@@ -23,3 +39,45 @@ static void fio_write_text(const char *path, const char *text) {
   fclose(f);
 }
 
+
+__attribute__((unused))
+static void fio_unmap(fio_Map *map) {
+  if (map->data == NULL) return;
+#ifdef _FIO_MMAP
+  if (map->_mapped)
+    munmap((void*)map->data, map->size);
+  else
+#endif
+    free((void*)map->data);
+  *map = (fio_Map) { 0 };
+}
+
+/* Falls back to reading the file into memory where mmap isn't available */
+__attribute__((unused))
+static bool fio_map(const char *path, fio_Map *map) {
+  *map = (fio_Map) { 0 };
+#ifdef _FIO_MMAP
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED)
+      *map = (fio_Map) { .data = data, .size = (size_t)st.st_size, ._mapped = true };
+  }
+  close(fd);
+#else
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) return false;
+  fseek(f, 0, SEEK_END);
+  size_t size = (size_t)ftell(f);
+  fseek(f, 0, SEEK_SET);
+  void *data = size > 0 ? malloc(size) : NULL;
+  if (data != NULL && fread(data, 1, size, f) == size)
+    *map = (fio_Map) { .data = data, .size = size };
+  else
+    free(data);
+  fclose(f);
+#endif
+  return map->data != NULL;
+}
@@ -0,0 +1,308 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/* Work-stealing jobs for splitting the simulation tick across cores.
+ *
+ * Unlike worker.h, which runs slow loads in the background while frames go
+ * on, these jobs are short and the caller waits for them: job_parallel_for
+ * cuts a range into jobs, and job_wait runs jobs itself until the ones it
+ * waits for are done. Each thread, the main one included, has its own deque.
+ * It pushes and pops jobs at the bottom, threads that ran out of work steal
+ * from the top of the others'. A stage that depends on another waits on its
+ * job_Counter before it starts.
+ *
+ * Without threads (emscripten, or if none could be started) every job runs
+ * as soon as it's pushed. */
+
+#ifdef __EMSCRIPTEN__
+#define JOB_THREADS (0)
+#else
+#define JOB_THREADS (1)
+#endif
+
+#define JOB_MAX_THREADS (16)
+/* jobs each deque holds, pushing onto a full one runs the job right away */
+#define JOB_DEQUE_SIZE (256)
+
+#if JOB_THREADS
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK _job_Mutex;
+typedef CONDITION_VARIABLE _job_Cond;
+typedef HANDLE _job_Thread;
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+typedef pthread_mutex_t _job_Mutex;
+typedef pthread_cond_t _job_Cond;
+typedef pthread_t _job_Thread;
+#endif
+#endif
+
+#ifdef _MSC_VER
+#define _JOB_THREAD_LOCAL __declspec(thread)
+#else
+#define _JOB_THREAD_LOCAL __thread
+#endif
+
+/* Handles items [begin, end) of whatever `arg` describes */
+typedef void (*job_Fn)(void *arg, size_t begin, size_t end);
+
+/* Jobs pushed with this counter that haven't returned yet, see job_wait */
+typedef struct {
+  volatile long pending;
+} job_Counter;
+
+typedef struct {
+  job_Fn fn;
+  void *arg;
+  size_t begin, end;
+  job_Counter *counter;
+} _job_Job;
+
+typedef struct {
+  _job_Job jobs[JOB_DEQUE_SIZE];
+  /* the owner pushes and pops at bottom, thieves take from top */
+  size_t top, bottom;
+#if JOB_THREADS
+  _job_Mutex mutex;
+#endif
+} _job_Deque;
+
+static struct {
+  /* deques[0] is the main thread's, the workers follow */
+  _job_Deque deques[JOB_MAX_THREADS];
+  /* deques in use, set before any worker starts, and the workers that did */
+  size_t thread_count, started;
+  /* jobs in all the deques, the workers sleep while there are none */
+  volatile long queued;
+#if JOB_THREADS
+  _job_Thread threads[JOB_MAX_THREADS];
+  _job_Mutex sleep_mutex;
+  _job_Cond wake;
+  bool quit;
+#endif
+} _job_state;
+
+/* index of the calling thread's deque */
+static _JOB_THREAD_LOCAL size_t _job_self;
+
+#ifdef _MSC_VER
+static long _job_atomic_add(volatile long *at, long value) { return InterlockedExchangeAdd(at, value) + value; }
+static long _job_atomic_load(volatile long *at) { return InterlockedCompareExchange(at, 0, 0); }
+#else
+static long _job_atomic_add(volatile long *at, long value) { return __atomic_add_fetch(at, value, __ATOMIC_ACQ_REL); }
+static long _job_atomic_load(volatile long *at) { return __atomic_load_n(at, __ATOMIC_ACQUIRE); }
+#endif
+
+#if JOB_THREADS
+#ifdef _WIN32
+static void _job_init_mutex(_job_Mutex *m) { InitializeSRWLock(m); }
+static void _job_lock(_job_Mutex *m) { AcquireSRWLockExclusive(m); }
+static void _job_unlock(_job_Mutex *m) { ReleaseSRWLockExclusive(m); }
+static void _job_wait_wake(void) { SleepConditionVariableSRW(&_job_state.wake, &_job_state.sleep_mutex, INFINITE, 0); }
+static void _job_wake_all(void) { WakeAllConditionVariable(&_job_state.wake); }
+static void _job_yield(void) { SwitchToThread(); }
+#else
+static void _job_init_mutex(_job_Mutex *m) { pthread_mutex_init(m, NULL); }
+static void _job_lock(_job_Mutex *m) { pthread_mutex_lock(m); }
+static void _job_unlock(_job_Mutex *m) { pthread_mutex_unlock(m); }
+static void _job_wait_wake(void) { pthread_cond_wait(&_job_state.wake, &_job_state.sleep_mutex); }
+static void _job_wake_all(void) { pthread_cond_broadcast(&_job_state.wake); }
+static void _job_yield(void) { sched_yield(); }
+#endif
+#endif
+
+static void _job_execute(_job_Job *job) {
+  job->fn(job->arg, job->begin, job->end);
+  _job_atomic_add(&job->counter->pending, -1);
+}
+
+static bool _job_push(_job_Job job) {
+  _job_Deque *d = _job_state.deques + _job_self;
+#if JOB_THREADS
+  _job_lock(&d->mutex);
+#endif
+  bool pushed = d->bottom - d->top < JOB_DEQUE_SIZE;
+  if (pushed)
+    d->jobs[d->bottom++ % JOB_DEQUE_SIZE] = job;
+#if JOB_THREADS
+  _job_unlock(&d->mutex);
+#endif
+  if (pushed)
+    _job_atomic_add(&_job_state.queued, 1);
+  return pushed;
+}
+
+/* Pops the newest job of the caller's deque, or steals the oldest of another's */
+static bool _job_take(_job_Job *job) {
+  for (size_t i = 0; i < _job_state.thread_count; i++) {
+    size_t index = (_job_self + i) % _job_state.thread_count;
+    _job_Deque *d = _job_state.deques + index;
+#if JOB_THREADS
+    _job_lock(&d->mutex);
+#endif
+    bool taken = d->bottom != d->top;
+    if (taken)
+      *job = index == _job_self ? d->jobs[--d->bottom % JOB_DEQUE_SIZE] : d->jobs[d->top++ % JOB_DEQUE_SIZE];
+#if JOB_THREADS
+    _job_unlock(&d->mutex);
+#endif
+    if (taken) {
+      _job_atomic_add(&_job_state.queued, -1);
+      return true;
+    }
+  }
+  return false;
+}
+
+#if JOB_THREADS
+static void _job_loop(size_t self) {
+  _job_self = self;
+  for (;;) {
+    _job_Job job;
+    if (_job_take(&job)) {
+      _job_execute(&job);
+      continue;
+    }
+
+    _job_lock(&_job_state.sleep_mutex);
+    while (_job_atomic_load(&_job_state.queued) == 0 && !_job_state.quit)
+      _job_wait_wake();
+    bool quit = _job_state.quit;
+    _job_unlock(&_job_state.sleep_mutex);
+    if (quit) break;
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI _job_main(LPVOID self) {
+  _job_loop((size_t)self);
+  return 0;
+}
+#else
+static void *_job_main(void *self) {
+  _job_loop((size_t)self);
+  return NULL;
+}
+#endif
+#endif
+
+/* Threads jobs run on, counting the main thread */
+__attribute__((unused))
+static size_t job_thread_count(void) {
+  return _job_state.started + 1;
+}
+
+/* Starts a worker for every core but the main thread's, `core_count` as worker_core_count gives it */
+__attribute__((unused))
+static void job_init(size_t core_count) {
+  memset(&_job_state, 0, sizeof(_job_state));
+  _job_state.thread_count = 1;
+  _job_self = 0;
+#if JOB_THREADS
+  if (core_count > JOB_MAX_THREADS) core_count = JOB_MAX_THREADS;
+  if (core_count > 1) _job_state.thread_count = core_count;
+  for (size_t i = 0; i < JOB_MAX_THREADS; i++)
+    _job_init_mutex(&_job_state.deques[i].mutex);
+  _job_init_mutex(&_job_state.sleep_mutex);
+#ifdef _WIN32
+  InitializeConditionVariable(&_job_state.wake);
+#else
+  pthread_cond_init(&_job_state.wake, NULL);
+#endif
+
+  /* the deques of workers that couldn't be started simply stay empty */
+  for (size_t i = 1; i < _job_state.thread_count; i++) {
+#ifdef _WIN32
+    _job_state.threads[i] = CreateThread(NULL, 0, _job_main, (LPVOID)i, 0, NULL);
+    if (_job_state.threads[i] == NULL) break;
+#else
+    if (pthread_create(_job_state.threads + i, NULL, _job_main, (void*)i) != 0) break;
+#endif
+    _job_state.started++;
+  }
+#else
+  (void)core_count;
+#endif
+}
+
+/* Calls `fn(arg, begin, end)` over [0, count) in slices of `grain` items,
+ * spread over the threads. `counter` counts them until they return. */
+__attribute__((unused))
+static void job_parallel_for(job_Counter *counter, job_Fn fn, void *arg, size_t count, size_t grain) {
+  assert(grain > 0 && "Slices need at least one item");
+  size_t pushed = 0;
+  for (size_t begin = 0; begin < count; begin += grain) {
+    _job_Job job = { fn, arg, begin, begin + grain < count ? begin + grain : count, counter };
+    _job_atomic_add(&counter->pending, 1);
+    if (_job_state.started > 0 && _job_push(job))
+      pushed++;
+    else
+      _job_execute(&job);
+  }
+
+#if JOB_THREADS
+  if (pushed > 0) {
+    /* under the mutex, so a worker can't miss it between checking and sleeping */
+    _job_lock(&_job_state.sleep_mutex);
+    _job_wake_all();
+    _job_unlock(&_job_state.sleep_mutex);
+  }
+#else
+  (void)pushed;
+#endif
+}
+
+/* Returns once every job counted by `counter` has, running queued jobs meanwhile */
+__attribute__((unused))
+static void job_wait(job_Counter *counter) {
+  while (_job_atomic_load(&counter->pending) > 0) {
+    _job_Job job;
+    if (_job_take(&job))
+      _job_execute(&job);
+#if JOB_THREADS
+    else
+      _job_yield();
+#endif
+  }
+}
+
+/* job_parallel_for and then job_wait, for a stage the next one depends on */
+__attribute__((unused))
+static void job_for(job_Fn fn, void *arg, size_t count, size_t grain) {
+  job_Counter counter = { 0 };
+  job_parallel_for(&counter, fn, arg, count, grain);
+  job_wait(&counter);
+}
+
+/* Adds `value` to a total that several jobs add to, returns the new total */
+__attribute__((unused))
+static long job_atomic_add(volatile long *total, long value) {
+  return _job_atomic_add(total, value);
+}
+
+/* Stops the workers, there mustn't be any jobs left */
+__attribute__((unused))
+static void job_shutdown(void) {
+#if JOB_THREADS
+  _job_lock(&_job_state.sleep_mutex);
+  _job_state.quit = true;
+  _job_wake_all();
+  _job_unlock(&_job_state.sleep_mutex);
+  for (size_t i = 1; i <= _job_state.started; i++) {
+#ifdef _WIN32
+    WaitForSingleObject(_job_state.threads[i], INFINITE);
+    CloseHandle(_job_state.threads[i]);
+#else
+    pthread_join(_job_state.threads[i], NULL);
+#endif
+  }
+#endif
+  _job_state.thread_count = 1;
+  _job_state.started = 0;
+}
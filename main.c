@@ -41,6 +41,14 @@ typedef uint64_t Tick;
 #include "math.h"
 #include "fio.h"
 #include "obj.h"
+#include "meshopt.h"
+#include "mcache.h"
+#include "mip.h"
+#include "bcn.h"
+#include "asset.h"
+#include "worker.h"
+#include "job.h"
+#include "watch.h"
 
 #include "input.h"
 
@@ -192,12 +200,29 @@ static Ent* try_gendex(GenDex gd) {
 
 typedef enum { Shader_Standard, Shader_Laser, Shader_ForceField, Shader_COUNT } Shader;
 
+/* a LOD is used once it deviates from the full mesh by less than this on screen */
+#define MESH_LOD_MAX_PIXEL_ERROR (1.0f)
+
+/* A range of a Mesh's index buffer drawing it at a certain level of detail */
+typedef struct {
+  size_t index_offset, index_count;
+  /* how far the simplified surface strays from the full one, in model space */
+  float error;
+} MeshLod;
+
 typedef struct {
   sg_buffer ibuf, vbuf;
+  /* small meshes keep 16 bit indices, see mesh_pipeline */
+  sg_index_type index_type;
   sg_image texture;
   Shader shader;
   size_t id;
-  size_t index_count;
+  /* lods[0] is the full mesh, following ones have about half as many triangles each */
+  MeshLod lods[MESH_MAX_LODS];
+  size_t lod_count;
+  /* model space bounding box and uv range, which the quantized vertices span */
+  Vec3 bounds_min, bounds_max;
+  Vec2 uv_min, uv_max;
 } Mesh;
 
 typedef struct {
@@ -217,13 +242,44 @@ static int cam_ent_cmp(const void *av, const void *bv) {
 }
 
 #define OFFSCREEN_SAMPLE_COUNT (4)
+/* vertical field of view, in radians */
+#define CAM_FOV (1.047f)
 #define STATE_MAX_ENTS (1 << 12)
-#define BLUR_PASSES (4)
+#define BLOOM_MAX_LEVELS (6)
+
+/* Picks how many times the bright target is halved by the bloom chain.
+ * Every extra level widens the glow for a quarter of the previous level's cost. */
+typedef enum { BloomQuality_Low, BloomQuality_Medium, BloomQuality_High, BloomQuality_COUNT } BloomQuality;
+static const int bloom_quality_levels[BloomQuality_COUNT] = {
+  [BloomQuality_Low]    = 3,
+  [BloomQuality_Medium] = 4,
+  [BloomQuality_High]   = BLOOM_MAX_LEVELS,
+};
+
+/* Dual only filters while walking the chain; Gaussian additionally blurs every
+ * level horizontally and vertically before it is upsampled, for a softer glow. */
+typedef enum { BloomFilter_Dual, BloomFilter_Gaussian, BloomFilter_COUNT } BloomFilter;
+
+/* texture fetches per pixel of each bloom shader, see shaders.glsl */
+#define BLOOM_DOWN_TAPS (5)
+#define BLOOM_UP_TAPS (8)
+#define BLOOM_BLUR_TAPS (5)
+
 typedef struct {
-  sg_pipeline pip[Shader_COUNT];
+  /* per shader, one for 16 and one for 32 bit index buffers */
+  sg_pipeline pip[Shader_COUNT][2];
   Mesh meshes[Art_COUNT];
+  /* stands in for meshes and textures that are still loading, see make_placeholders */
+  Mesh placeholder;
+  /* mask of the bcn_Formats the GPU can sample, see load_texture */
+  uint32_t texture_formats;
   Ent ents[STATE_MAX_ENTS];
   CamEnt cam_ents[STATE_MAX_ENTS];
+  /* queued by spawn_ent and remove_ent until the next flush_ents */
+  Ent spawns[STATE_MAX_ENTS];
+  size_t spawn_count;
+  Ent *removed[STATE_MAX_ENTS];
+  long removed_count;
   GenDex player;
   float player_turn_accel;
   size_t gem_count;
@@ -239,10 +295,21 @@ typedef struct {
     sg_pipeline pip;
   } fsq;
   struct {
-    sg_image imgs[BLUR_PASSES][2];
-    sg_pass passes[BLUR_PASSES][2];
-    sg_pipeline pip;
-  } blur;
+    BloomQuality quality;
+    BloomFilter filter;
+    int levels;
+    /* imgs[0] is half the window size, each following level halves it again */
+    sg_image imgs[BLOOM_MAX_LEVELS];
+    sg_pass passes[BLOOM_MAX_LEVELS];
+    int pixels[BLOOM_MAX_LEVELS];
+    /* only allocated for BloomFilter_Gaussian, holds the horizontal pass */
+    sg_image blur_imgs[BLOOM_MAX_LEVELS];
+    sg_pass blur_passes[BLOOM_MAX_LEVELS];
+    sg_pipeline down_pip, up_pip, blur_pip;
+    blur_fs_params_t blur_params;
+    /* texture fetches issued by the last draw_bloom, for comparing filters */
+    uint64_t fetches;
+  } bloom;
 } State;
 static State *state;
 
@@ -263,6 +330,14 @@ static Ent *add_ent(Ent ent) {
   return NULL;
 }
 
+/* Queues `ent` to be added by the next flush_ents, so nothing that's
+ * iterating over the pool meets it halfway through. Main thread only,
+ * spawns are added in the order they were queued. */
+static void spawn_ent(Ent ent) {
+  if (state->spawn_count < STATE_MAX_ENTS)
+    state->spawns[state->spawn_count++] = ent;
+}
+
 /* ends `count` copies of Ent off into different directions */
 static void split_into(int count, Ent ent) {
   float offset = randf() * PI_f;
@@ -271,11 +346,20 @@ static void split_into(int count, Ent ent) {
     Vec2 dir = vec2_rot(randf() * 0.3f + offset + t * PI_f * 2.0f);
     ent.vel = mul2_f(dir, 0.2f);
     ent.pos = add2(ent.pos, mul2_f(dir, 2.0f * ent.collider.size));
-    add_ent(ent);
+    spawn_ent(ent);
   }
 }
 
+/* Takes `ent` out of the game right away: iterating skips it and its
+ * GenDex goes stale. Its slot keeps its contents until the next flush_ents
+ * splits it. Jobs may remove the entities they're looking at. */
 static void remove_ent(Ent *ent) {
+  if (!take_ent_prop(ent, EntProp_Active)) return;
+  ent->generation++;
+  state->removed[job_atomic_add(&state->removed_count, 1) - 1] = ent;
+}
+
+static void split_removed(Ent *ent) {
   if (has_ent_prop(ent, EntProp_AsteroidSplit)) {
     if (ent->collider.size > 0.5f) {
       ent->collider.weight -= 0.3f;
@@ -294,8 +378,27 @@ static void remove_ent(Ent *ent) {
       });
     }
   }
-  ent->generation++;
-  take_ent_prop(ent,EntProp_Active);
+}
+
+static int removed_cmp(const void *av, const void *bv) {
+  Ent *a = *(Ent **) av;
+  Ent *b = *(Ent **) bv;
+  return (a > b) - (a < b);
+}
+
+/* Splits what was removed since the last flush, in pool order whichever
+ * threads removed it, then adds everything spawned meanwhile. tick() calls
+ * this between stages, so spawns never show up in the middle of one. */
+static void flush_ents(void) {
+  size_t removed_count = (size_t)state->removed_count;
+  qsort(state->removed, removed_count, sizeof(Ent *), removed_cmp);
+  for (size_t i = 0; i < removed_count; i++)
+    split_removed(state->removed[i]);
+  state->removed_count = 0;
+
+  for (size_t i = 0; i < state->spawn_count; i++)
+    add_ent(state->spawns[i]);
+  state->spawn_count = 0;
 }
 
 /* Use this function to iterate over all of the Ents in the game.
@@ -310,9 +413,10 @@ static inline Ent *ent_all_iter(Ent *ent) {
   return NULL;
 }
 
-static void fire_laser(Ent *ent) {
+/* A laser leaving `ent`, credited to `parent`, which is `ent` unless that's a copy */
+static Ent laser_ent(Ent *ent, GenDex parent) {
   Vec2 e_dir = vec2_swap(vec2_rot(ent->angle));
-  add_ent((Ent) {
+  return (Ent) {
     .props = new_bundle(EntProp_Projectile),
     .art = Art_Laser,
     .bloom = 1.0,
@@ -324,94 +428,367 @@ static void fire_laser(Ent *ent) {
     .collider.size = 0.2f,
     .collider.weight = 1.0f,
     .damage = ent->damage,
-    .parent = get_gendex(ent),
-  });
+    .parent = parent,
+  };
+}
+
+static void fire_laser(Ent *ent) {
+  spawn_ent(laser_ent(ent, get_gendex(ent)));
 }
 
 ol_Image gem_image;
 
+static sg_pipeline mesh_pipeline(Mesh *mesh) {
+  return state->pip[mesh->shader][mesh->index_type == SG_INDEXTYPE_UINT32];
+}
+
 #include "build.h"
 #include "collision.h"
 #include "player.h"
 #include "ai.h"
 
-void load_texture(Art art, const char *texture) {
-  cp_image_t player_png = cp_load_png(texture);
-  cp_flip_image_horizontal(&player_png);
-  int w = player_png.w;
-  int h = player_png.h;
-  if (art == Art_Ship || art == Art_Pillar)
-    state->meshes[art].texture = sg_make_image_with_mipmaps(&(sg_image_desc){
-      .width = w,
-      .height = h,
-      .pixel_format = SG_PIXELFORMAT_RGBA8,
-      .num_mipmaps = 10,
-      .min_filter = SG_FILTER_LINEAR_MIPMAP_LINEAR,
-      .mag_filter = SG_FILTER_LINEAR,
-      .max_anisotropy = 8,
-      .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
-      .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
-      .data.subimage[0][0] = (sg_range){ player_png.pix,w*h*sizeof(cp_pixel_t) } ,
-    });
-  else 
-    state->meshes[art].texture = sg_make_image(&(sg_image_desc){
-      .width = w,
-      .height = h,
-      .max_anisotropy = 8,
-      .min_filter = SG_FILTER_LINEAR,
-      .mag_filter = SG_FILTER_LINEAR,
-      .data.subimage[0][0] = (sg_range){ player_png.pix, w*h*sizeof(cp_pixel_t) } ,
-    });
-  cp_free_png(&player_png);
+/* what each bcn_Format is uploaded as */
+static const sg_pixel_format bcn_pixel_formats[bcn_Format_COUNT] = {
+  [bcn_Format_RGBA8] = SG_PIXELFORMAT_RGBA8,
+  [bcn_Format_BC1] = SG_PIXELFORMAT_BC1_RGBA,
+  [bcn_Format_BC3] = SG_PIXELFORMAT_BC3_RGBA,
+  [bcn_Format_BC7] = SG_PIXELFORMAT_BC7_RGBA,
+};
+
+/* Meshes and their textures are loaded on the workers, see worker.h, and
+ * uploaded to the GPU by the finish half of each job. Until then an art is
+ * drawn as the placeholder cube, textured with the placeholder texture. */
+typedef struct {
+  Art art;
+  const char *path;
+  /* state->texture_formats when it was queued */
+  uint32_t formats;
+  /* set by load_texture_run, `levels` point into the baked texture when
+   * there is one in a format the GPU takes, otherwise into `pixels`, the
+   * decoded png and its mips, compressed if the GPU can sample that */
+  asset_Texture baked;
+  uint8_t *pixels;
+  uint32_t width, height, mip_count;
+  bcn_Format format;
+  const uint8_t *levels[ASSET_MAX_MIPS];
+} TextureLoad;
+
+static void load_texture_run(void *arg) {
+  TextureLoad *load = arg;
+  asset_Texture *baked = &load->baked;
+  const uint8_t *chain;
+  if (asset_open_texture(load->path, true, load->formats, baked)) {
+    load->width = baked->header->width;
+    load->height = baked->header->height;
+    load->mip_count = baked->header->mip_count;
+    load->format = (bcn_Format)baked->header->format;
+    chain = baked->levels[0];
+  } else {
+    cp_image_t png = cp_load_png(load->path);
+    if (png.pix == NULL) return;
+    cp_flip_image_horizontal(&png);
+    load->width = (uint32_t)png.w;
+    load->height = (uint32_t)png.h;
+    load->mip_count = (uint32_t)mip_count(load->width, load->height);
+    load->format = bcn_Format_RGBA8;
+    /* the chain is built behind the decoded base level */
+    load->pixels = realloc(png.pix, mip_chain_size(load->width, load->height, load->mip_count));
+    mip_build(load->pixels, load->width, load->height, load->mip_count);
+    chain = load->pixels;
+  }
+
+  /* only RGBA8 was baked, or nothing, compress it here if the GPU can sample that */
+  if (load->format == bcn_Format_RGBA8) {
+    bcn_Format format = bcn_pick(load->formats, load->width, load->height,
+                                 bcn_opaque(chain, load->width, load->height));
+    if (format != bcn_Format_RGBA8) {
+      uint8_t *blocks = malloc(bcn_chain_size(format, load->width, load->height, load->mip_count));
+      bcn_encode_chain(format, chain, load->width, load->height, load->mip_count, blocks);
+      if (baked->header != NULL)
+        asset_close_texture(baked);
+      free(load->pixels);
+      load->pixels = blocks;
+      load->format = format;
+      chain = blocks;
+    }
+  }
+  for (uint32_t i = 0; i < load->mip_count; i++)
+    load->levels[i] = chain + bcn_chain_size(load->format, load->width, load->height, i);
 }
 
-void load_mesh(Art art, Shader shader, const char *path, const char *texture) {
-  char *input = fio_read_text(path);
-  if (input == NULL) {
-    fprintf(stderr, "Could not load asset %s, file inaccessible\n", path);
-    exit(1);
+static void load_texture_finish(void *arg) {
+  TextureLoad *load = arg;
+  Art art = load->art;
+  if (load->mip_count == 0) {
+    fprintf(stderr, "Could not load texture %s\n", load->path);
+    free(load);
+    return;
   }
-  obj_Result res = obj_parse(input);
-  size_t vertex_count;
-  obj_Unrolled unrolled = obj_unroll_pun(&res, &vertex_count);
-  obj_dispose(&res);
-  
+
+  /* every texture seen in 3D gets its whole mip chain */
+  sg_image_desc desc = {
+    .width = (int)load->width,
+    .height = (int)load->height,
+    .pixel_format = bcn_pixel_formats[load->format],
+    .num_mipmaps = (int)m_min(load->mip_count, (uint32_t)SG_MAX_MIPMAPS),
+    .max_anisotropy = 8,
+    .min_filter = SG_FILTER_LINEAR_MIPMAP_LINEAR,
+    .mag_filter = SG_FILTER_LINEAR,
+  };
+  if (art == Art_Ship || art == Art_Pillar)
+    desc.wrap_u = desc.wrap_v = SG_WRAP_CLAMP_TO_EDGE;
+  for (int i = 0; i < desc.num_mipmaps; i++) {
+    uint32_t w = m_max(load->width >> i, 1u), h = m_max(load->height >> i, 1u);
+    desc.data.subimage[0][i] = (sg_range){ load->levels[i], bcn_level_size(load->format, w, h) };
+  }
+  /* a reload replaces the texture loaded before it */
+  sg_image old = state->meshes[art].texture;
+  if (old.id != SG_INVALID_ID && old.id != state->placeholder.texture.id)
+    sg_destroy_image(old);
+  state->meshes[art].texture = sg_make_image(&desc);
+
+  if (load->baked.header != NULL)
+    asset_close_texture(&load->baked);
+  free(load->pixels);
+  free(load);
+}
+
+void load_texture(Art art, const char *texture) {
+  TextureLoad *load = calloc(1, sizeof(TextureLoad));
+  load->art = art;
+  load->path = texture;
+  load->formats = state->texture_formats;
+  worker_push(load_texture_run, load_texture_finish, load);
+}
+
+static void mesh_upload(Mesh *mesh, const mcache_Header *header, const mcache_Vertex *vertices, const void *indices) {
+  mesh->lod_count = header->lod_count;
+  for (size_t i = 0; i < mesh->lod_count; i++)
+    mesh->lods[i] = (MeshLod) {
+      .index_offset = header->lods[i].index_offset,
+      .index_count = header->lods[i].index_count,
+      .error = header->lods[i].error,
+    };
+  mesh->bounds_min = vec3(header->bounds_min[0], header->bounds_min[1], header->bounds_min[2]);
+  mesh->bounds_max = vec3(header->bounds_max[0], header->bounds_max[1], header->bounds_max[2]);
+  mesh->uv_min = vec2(header->uv_min[0], header->uv_min[1]);
+  mesh->uv_max = vec2(header->uv_max[0], header->uv_max[1]);
 
   /* a vertex buffer */
-  sg_buffer vbuf = sg_make_buffer(&(sg_buffer_desc){
-    .data = (sg_range){unrolled.vertices, vertex_count*8*sizeof(float)},
+  mesh->vbuf = sg_make_buffer(&(sg_buffer_desc){
+    .data = (sg_range){vertices, (size_t)header->vertex_count*header->stride},
   });
-  sg_buffer ibuf = sg_make_buffer(&(sg_buffer_desc){
+  mesh->ibuf = sg_make_buffer(&(sg_buffer_desc){
     .type = SG_BUFFERTYPE_INDEXBUFFER,
-    .data = (sg_range){unrolled.indices, res.index_count*sizeof(uint16_t)},
+    .data = (sg_range){indices, (size_t)header->index_count*header->index_size},
   });
+  mesh->index_type = header->index_size == 2 ? SG_INDEXTYPE_UINT16 : SG_INDEXTYPE_UINT32;
+}
+
+/* A grey unit cube, shared by every art still waiting for its mesh or texture */
+static void make_placeholders(void) {
+  float vertices[24*8] = { 0 };
+  uint16_t indices[36];
+  const uint16_t quad[6] = { 0, 1, 2, 2, 3, 0 };
+  for (int face = 0; face < 6; face++) {
+    int axis = face/2, u = (axis + 1)%3, v = (axis + 2)%3;
+    float sign = face%2 ? -1.0f : 1.0f;
+    for (int corner = 0; corner < 4; corner++) {
+      float cu = (corner == 1 || corner == 2) ? 0.5f : -0.5f;
+      float cv = corner >= 2 ? 0.5f : -0.5f;
+      float *vert = vertices + (face*4 + corner)*8;
+      /* mirroring u winds the faces on the negative side outwards as well */
+      vert[axis] = 0.5f*sign;
+      vert[u] = cu*sign;
+      vert[v] = cv;
+      vert[3] = cu + 0.5f;
+      vert[4] = cv + 0.5f;
+      vert[5 + axis] = sign;
+    }
+    for (int i = 0; i < 6; i++)
+      indices[face*6 + i] = (uint16_t)(face*4 + quad[i]);
+  }
 
-  state->meshes[art] = (Mesh) {
-    .ibuf = ibuf,
-    .vbuf = vbuf, 
-    .id = art,
-    .shader = shader,
-    .index_count = res.index_count,
+  mcache_Header header = {
+    .vertex_count = 24,
+    .index_count = 36,
+    .stride = sizeof(mcache_Vertex),
+    .index_size = sizeof(uint16_t),
+    .lod_count = 1,
+    .lods[0].index_count = 36,
   };
+  mcache_Vertex quantized[24];
+  asset_quantize(&header, vertices, 24, quantized);
+  mesh_upload(&state->placeholder, &header, quantized, indices);
+
+  const uint8_t grey[4] = { 128, 128, 128, 255 };
+  state->placeholder.texture = sg_make_image(&(sg_image_desc){
+    .width = 1,
+    .height = 1,
+    .data.subimage[0][0] = SG_RANGE(grey),
+  });
+}
+
+typedef struct {
+  Art art;
+  const char *path;
+  /* a copy, the caller's parts may not outlive load_composite_mesh */
+  Mat4 *parts;
+  size_t part_count;
+  /* the art already has a mesh that it keeps if this one can't be loaded */
+  bool reload;
+  /* set by load_mesh_run, `cache` is mapped when `cached`, otherwise the
+   * mesh was processed into `header`, `vertices` and `indices` */
+  bool failed, cached;
+  mcache_File cache;
+  mcache_Header header;
+  mcache_Vertex *vertices;
+  void *indices;
+} MeshLoad;
+
+static void load_mesh_run(void *arg) {
+  MeshLoad *load = arg;
+  const char *baked = asset_find("mesh", load->path);
+#ifdef NDEBUG
+  /* shipping builds trust the baker and never touch the source */
+  load->cached = baked != NULL && mcache_open(baked, MCACHE_ANY_HASH, &load->cache);
+  if (load->cached) return;
+#endif
+
+  char *input = fio_read_text(load->path);
+  if (input == NULL) {
+    load->failed = true;
+    return;
+  }
+  uint64_t hash = asset_mesh_hash(input, strlen(input), load->parts, load->part_count);
+  char cache_path[256];
+  snprintf(cache_path, sizeof(cache_path), "build/%s.mesh", load->path);
+  load->cached = (baked != NULL && mcache_open(baked, hash, &load->cache)) ||
+                 mcache_open(cache_path, hash, &load->cache);
+
+  if (!load->cached) {
+    load->header = asset_process_mesh(load->path, input, load->parts, load->part_count,
+                                      &load->vertices, &load->indices);
+    load->header.hash = hash;
+    if (!mcache_save(cache_path, &load->header, load->vertices, load->indices))
+      fprintf(stderr, "Could not write mesh cache %s\n", cache_path);
+  }
+  free(input);
+}
+
+static void load_mesh_finish(void *arg) {
+  MeshLoad *load = arg;
+  if (load->failed) {
+    fprintf(stderr, "Could not load asset %s, file inaccessible\n", load->path);
+    if (!load->reload) exit(1);
+    free(load->parts);
+    free(load);
+    return;
+  }
+
+  /* the texture may have arrived first, so only the geometry is replaced */
+  Mesh *mesh = state->meshes + load->art;
+  if (mesh->vbuf.id != state->placeholder.vbuf.id) {
+    sg_destroy_buffer(mesh->vbuf);
+    sg_destroy_buffer(mesh->ibuf);
+  }
+  if (load->cached) {
+    mesh_upload(mesh, load->cache.header, load->cache.vertices, load->cache.indices);
+    mcache_close(&load->cache);
+  } else {
+    mesh_upload(mesh, &load->header, load->vertices, load->indices);
+    free(load->vertices);
+    free(load->indices);
+  }
+  free(load->parts);
+  free(load);
+}
+
+/* Queues loading the geometry of `art`, see load_composite_mesh */
+static void load_mesh(Art art, const char *path, const Mat4 *parts, size_t part_count, bool reload) {
+  MeshLoad *load = calloc(1, sizeof(MeshLoad));
+  load->art = art;
+  load->path = path;
+  load->parts = malloc(part_count*sizeof(Mat4));
+  if (part_count > 0)
+    memcpy(load->parts, parts, part_count*sizeof(Mat4));
+  load->part_count = part_count;
+  load->reload = reload;
+  worker_push(load_mesh_run, load_mesh_finish, load);
+}
 
+/* Loads a mesh made out of `part_count` copies of the model at `path`, each
+ * placed by one of the transforms in `parts`, so that multi-part arts are
+ * still drawn in one call. With no parts, the model is loaded as is.
+ * A baked mesh is preferred, otherwise the processed mesh is cached in
+ * build/ and reused while the model, the parts and the LOD settings stay the same. */
+void load_composite_mesh(Art art, Shader shader, const char *path, const char *texture,
+                         const Mat4 *parts, size_t part_count) {
+  Mesh *mesh = state->meshes + art;
+  *mesh = state->placeholder;
+  mesh->id = art;
+  mesh->shader = shader;
+  if (!texture)
+    mesh->texture = (sg_image){ 0 };
+
+  load_mesh(art, path, parts, part_count, false);
   if (texture)
     load_texture(art, texture);
+}
+
+#ifndef NDEBUG
+static bool same_path(const char *path, const char *other) {
+  return other != NULL && strcmp(path, other) == 0;
+}
 
-  obj_dispose_unrolled(&unrolled);
-  free((void*)input);
+/* Starts watching every file the meshes, the overlay and the ui load from */
+static void watch_assets(void) {
+  watch_init();
+#define X(art, shader, model, texture, parts, part_count) \
+  watch_add(model);                                       \
+  if (texture) watch_add(texture);
+  ASSET_MESHES(X)
+#undef X
+#define X(path) watch_add(path);
+  ASSET_IMAGES(X)
+  ASSET_ATLAS(X)
+  ASSET_FONTS(X)
+#undef X
 }
 
+/* Loads `path` again for everything that uses it, in place. Meshes and
+ * textures go through the workers and keep drawing the old version until
+ * the new one is uploaded, the game state doesn't notice. */
+static void reload_asset(const char *path) {
+  printf("Reloading %s\n", path);
+#define X(art, shader, model, texture, parts, part_count)          \
+  if (same_path(path, model)) load_mesh(art, model, parts, part_count, true); \
+  if (same_path(path, texture)) load_texture(art, texture);
+  ASSET_MESHES(X)
+#undef X
+  /* repacking can move every image in the atlas, not only the one that changed */
+  if (asset_atlas_find(path) >= 0) {
+    ol_reload_atlas();
+    gem_image = ol_load_image("./Gem.png");
+  }
+  ui_reload(path);
+}
+#endif
+
 void resize_framebuffers(void) {
   /* destroy previous resource (can be called for invalid id) */
   sg_destroy_pass(state->offscreen.pass);
   sg_destroy_image(state->offscreen.color_img);
   sg_destroy_image(state->offscreen.depth_img);
   sg_destroy_image(state->offscreen.bright_img);
-  for (int i = 0; i < BLUR_PASSES; i++)
-    for (int h = 0; h < 2; h++) {
-      sg_destroy_image(state->blur.imgs[i][h]);
-      sg_destroy_pass(state->blur.passes[i][h]);
-    }
+  for (int i = 0; i < BLOOM_MAX_LEVELS; i++) {
+    sg_destroy_image(state->bloom.imgs[i]);
+    sg_destroy_pass(state->bloom.passes[i]);
+    sg_destroy_image(state->bloom.blur_imgs[i]);
+    sg_destroy_pass(state->bloom.blur_passes[i]);
+    state->bloom.imgs[i] = state->bloom.blur_imgs[i] = (sg_image) { 0 };
+    state->bloom.passes[i] = state->bloom.blur_passes[i] = (sg_pass) { 0 };
+  }
 
   /* a render pass with one color- and one depth-attachment image */
   sg_image_desc img_desc = {
@@ -428,16 +805,27 @@ void resize_framebuffers(void) {
   state->offscreen.color_img = sg_make_image(&img_desc);
   state->offscreen.bright_img = sg_make_image(&img_desc);
 
-  sg_image_desc blur_img_desc = img_desc;
-  for (int i = 0; i < BLUR_PASSES; i++)
-    for (int h = 0; h < 2; h++) {
-      state->blur.imgs[i][h] = sg_make_image(&blur_img_desc);
-      state->blur.passes[i][h] = sg_make_pass(&(sg_pass_desc) {
-        .color_attachments[0].image = state->blur.imgs[i][h]
+  /* the bloom chain only ever sees the resolved bright target,
+   * so its levels don't need to be multisampled */
+  sg_image_desc bloom_img_desc = img_desc;
+  bloom_img_desc.sample_count = 1;
+  state->bloom.levels = bloom_quality_levels[state->bloom.quality];
+  for (int i = 0; i < state->bloom.levels; i++) {
+    bloom_img_desc.width = m_max(bloom_img_desc.width / 2, 1);
+    bloom_img_desc.height = m_max(bloom_img_desc.height / 2, 1);
+    state->bloom.imgs[i] = sg_make_image(&bloom_img_desc);
+    state->bloom.passes[i] = sg_make_pass(&(sg_pass_desc) {
+      .color_attachments[0].image = state->bloom.imgs[i]
+    });
+    state->bloom.pixels[i] = bloom_img_desc.width * bloom_img_desc.height;
+
+    if (state->bloom.filter == BloomFilter_Gaussian) {
+      state->bloom.blur_imgs[i] = sg_make_image(&bloom_img_desc);
+      state->bloom.blur_passes[i] = sg_make_pass(&(sg_pass_desc) {
+        .color_attachments[0].image = state->bloom.blur_imgs[i]
       });
-      blur_img_desc.width /= 2;
-      blur_img_desc.height /= 2;
     }
+  }
 
   img_desc.pixel_format = SG_PIXELFORMAT_DEPTH_STENCIL;
   state->offscreen.depth_img = sg_make_image(&img_desc);
@@ -546,26 +934,35 @@ void init(void) {
   ai_init(en,AI_STATE_IDLE);
 
 
-  load_mesh(    Art_Ship,   Shader_Standard,     "./Bob.obj", "./Bob_Orange.png");
-  load_mesh(Art_Asteroid,   Shader_Standard,"./Asteroid.obj",       "./Moon.png");
-  load_mesh(   Art_Plane, Shader_ForceField,   "./Plane.obj",               NULL);
-  load_mesh(   Art_Laser,      Shader_Laser,   "./LASER.obj",    "./Mineral.png");
-  load_mesh( Art_Mineral,   Shader_Standard, "./Mineral.obj",    "./Mineral.png");
-  load_mesh(  Art_Pillar,   Shader_Standard,  "./Pillar.obj",     "./Pillar.png");
+  /* block compressed mesh textures where the GPU can sample them, see bcn_pick */
+  state->texture_formats = 1u << bcn_Format_RGBA8;
+  for (int format = bcn_Format_BC1; format < bcn_Format_COUNT; format++)
+    if (sg_query_pixelformat(bcn_pixel_formats[format]).sample)
+      state->texture_formats |= 1u << format;
+
+  asset_init();
+  mip_init();
+  worker_init();
+  job_init(worker_core_count());
+  make_placeholders();
+#define X(art, shader, model, texture, parts, part_count) \
+  load_composite_mesh(art, shader, model, texture, parts, part_count);
+  ASSET_MESHES(X)
+#undef X
 
-  ui_init();
   ol_init();
+  ui_init();
 
   /* a pipeline state object */
   sg_pipeline_desc desc = {
     .layout = {
       .attrs = {
-        [ATTR_vs_position].format = SG_VERTEXFORMAT_FLOAT3,
-        [ATTR_vs_uv].format       = SG_VERTEXFORMAT_FLOAT2,
-        [ATTR_vs_normal].format   = SG_VERTEXFORMAT_FLOAT3,
+        /* mcache_Vertex, dequantized by the vertex shaders */
+        [ATTR_vs_position].format = SG_VERTEXFORMAT_USHORT4N,
+        [ATTR_vs_uv].format       = SG_VERTEXFORMAT_USHORT2N,
+        [ATTR_vs_normal].format   = SG_VERTEXFORMAT_SHORT2N,
       }
     },
-    .index_type = SG_INDEXTYPE_UINT16,
     .cull_mode = SG_CULLMODE_BACK,
     .depth = {
       .write_enabled = true,
@@ -576,16 +973,23 @@ void init(void) {
     .colors[0].blend = PREMULTIPLIED_BLEND,
   }; 
 
-  desc.shader = sg_make_shader(mesh_shader_desc(sg_query_backend()));
-  state->pip[Shader_Standard] = sg_make_pipeline(&desc);
-
-  desc.shader = sg_make_shader(laser_shader_desc(sg_query_backend()));
-  state->pip[Shader_Laser] = sg_make_pipeline(&desc);
-
-  desc.shader = sg_make_shader(force_field_shader_desc(sg_query_backend()));
-  state->pip[Shader_ForceField] = sg_make_pipeline(&desc);
+  sg_shader shaders[Shader_COUNT] = {
+    [Shader_Standard]   = sg_make_shader(mesh_shader_desc(sg_query_backend())),
+    [Shader_Laser]      = sg_make_shader(laser_shader_desc(sg_query_backend())),
+    [Shader_ForceField] = sg_make_shader(force_field_shader_desc(sg_query_backend())),
+  };
+  for (int i = 0; i < Shader_COUNT; i++) {
+    desc.shader = shaders[i];
+    desc.index_type = SG_INDEXTYPE_UINT16;
+    state->pip[i][0] = sg_make_pipeline(&desc);
+    desc.index_type = SG_INDEXTYPE_UINT32;
+    state->pip[i][1] = sg_make_pipeline(&desc);
+  }
 
   gem_image = ol_load_image("./Gem.png");
+#ifndef NDEBUG
+  watch_assets();
+#endif
 
   /* a vertex buffer to render a fullscreen rectangle */
   state->fsq.quad_vbuf = sg_make_buffer(&(sg_buffer_desc){
@@ -603,15 +1007,44 @@ void init(void) {
     .label = "fullscreen quad pipeline"
   });
 
-  state->blur.pip = sg_make_pipeline(&(sg_pipeline_desc){
+  sg_pipeline_desc bloom_desc = {
     .layout = {
       .attrs[ATTR_fsq_vs_pos].format = SG_VERTEXFORMAT_FLOAT2
     },
-    .shader = sg_make_shader(blur_shader_desc(sg_query_backend())),
+    .shader = sg_make_shader(bloom_down_shader_desc(sg_query_backend())),
     .primitive_type = SG_PRIMITIVETYPE_TRIANGLE_STRIP,
     .depth.pixel_format = SG_PIXELFORMAT_NONE,
-    .label = "blur pipeline"
-  });
+    .sample_count = 1,
+    .label = "bloom downsample pipeline"
+  };
+  state->bloom.down_pip = sg_make_pipeline(&bloom_desc);
+
+  /* upsampled levels are added onto the downsampled ones above them */
+  bloom_desc.shader = sg_make_shader(bloom_up_shader_desc(sg_query_backend()));
+  bloom_desc.colors[0].blend = (sg_blend_state) {
+    .enabled = true,
+    .src_factor_rgb = SG_BLENDFACTOR_ONE,
+    .dst_factor_rgb = SG_BLENDFACTOR_ONE,
+  };
+  bloom_desc.label = "bloom upsample pipeline";
+  state->bloom.up_pip = sg_make_pipeline(&bloom_desc);
+
+  bloom_desc.shader = sg_make_shader(blur_shader_desc(sg_query_backend()));
+  bloom_desc.colors[0].blend = (sg_blend_state) { 0 };
+  bloom_desc.label = "bloom blur pipeline";
+  state->bloom.blur_pip = sg_make_pipeline(&bloom_desc);
+
+  /* Fold the 9-tap gaussian into 5 bilinear taps: for each pair of texels
+   * sharing a side, sample between them at the offset where the linear filter
+   * reproduces both of their weights. */
+  const float weight[] = { 0.227027f, 0.1945946f, 0.1216216f, 0.054054f, 0.016216f };
+  blur_fs_params_t *bp = &state->bloom.blur_params;
+  bp->weights = vec4(weight[0], weight[1] + weight[2], weight[3] + weight[4], 0.0f);
+  bp->offsets = vec4(0.0f,
+    (1.0f*weight[1] + 2.0f*weight[2]) / bp->weights.y,
+    (3.0f*weight[3] + 4.0f*weight[4]) / bp->weights.z, 0.0f);
+
+  state->bloom.quality = BloomQuality_Medium;
 
   resize_framebuffers();
 }
@@ -621,6 +1054,12 @@ static float ent_health_frac(Ent *ent) {
   return lerp(ent->health+1, ent->health, fminf(1, t)) / fmaxf(ent->max_hp, 1);
 }
 
+static Vec3 ent_scale(Ent *ent) {
+  Vec3 scale = (magmag3(ent->scale) == 0.0f) ? vec3_f(1.0f) : ent->scale;
+  if (ent->art == Art_Ship) scale = mul3_f(scale, 0.3f);
+  return scale;
+}
+
 static Mat4 ent_model_mat(Ent *ent) {
   Mat4 m = translate4x4(vec3(ent->pos.x, ent->height, ent->pos.y));
 
@@ -633,19 +1072,32 @@ static Mat4 ent_model_mat(Ent *ent) {
     m = mul4x4(m, rotate4x4(ent->passive_rotate_axis,
                             (float)state->tick/70.0f));
 
-  Vec3 scale = (magmag3(ent->scale) == 0.0f) ? vec3_f(1.0f) : ent->scale;
-  if (ent->art == Art_Ship) scale = mul3_f(scale, 0.3f);
-  m = mul4x4(m, scale4x4(scale));
+  m = mul4x4(m, scale4x4(ent_scale(ent)));
 
   return m;
 }
 
-/* naively renders with n draw calls per entity
- * TODO: optimize for fewer draw calls */
-static void draw_ent_internal(Mat4 vp, Ent *ent) {
+/* Picks the coarsest LOD whose error, projected onto the screen from
+ * `cam_dist` (squared) away, stays below MESH_LOD_MAX_PIXEL_ERROR */
+static MeshLod *mesh_lod(Mesh *mesh, Ent *ent, float cam_dist) {
+  Vec3 scale = ent_scale(ent);
+  float max_scale = fmaxf(scale.x, fmaxf(scale.y, scale.z));
+  float pixels_per_unit = sapp_heightf() / (2.0f * tanf(CAM_FOV / 2.0f) * sqrtf(cam_dist));
+
+  for (size_t i = mesh->lod_count - 1; i > 0; i--)
+    if (mesh->lods[i].error * max_scale * pixels_per_unit < MESH_LOD_MAX_PIXEL_ERROR)
+      return mesh->lods + i;
+  return mesh->lods;
+}
+
+/* renders with one draw call per entity, multi-part arts are baked
+ * into a single mesh by load_composite_mesh
+ * `cam_dist` is the squared distance from the camera, see CamEnt */
+static void draw_ent(Mat4 vp, Ent *ent, float cam_dist) {
   Mat4 m = ent_model_mat(ent);
 
   Mesh *mesh = state->meshes + ent->art;
+  MeshLod *lod = mesh_lod(mesh, ent, cam_dist);
 
   /* set up bindings for this mesh */
   sg_bindings bind = {
@@ -670,26 +1122,132 @@ static void draw_ent_internal(Mat4 vp, Ent *ent) {
     };
     sg_apply_uniforms(SG_SHADERSTAGE_FS, SLOT_mesh_fs_params, &SG_RANGE(fs_params));
   }
-  vs_params_t vs_params = { .view_proj = vp, .model = m };
+  Vec3 extent = sub3(mesh->bounds_max, mesh->bounds_min);
+  Vec2 uv_extent = sub2(mesh->uv_max, mesh->uv_min);
+  vs_params_t vs_params = {
+    .view_proj = vp,
+    .model = m,
+    .position_min = vec4(mesh->bounds_min.x, mesh->bounds_min.y, mesh->bounds_min.z, 0.0f),
+    .position_extent = vec4(extent.x, extent.y, extent.z, 0.0f),
+    .uv_range = vec4(mesh->uv_min.x, mesh->uv_min.y, uv_extent.x, uv_extent.y),
+  };
   sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, &SG_RANGE(vs_params));
 
-  sg_draw(0, mesh->index_count, 1);
+  sg_draw((int)lod->index_offset, (int)lod->index_count, 1);
+}
+
+/* One separable gaussian pass of `src` along `dir` into `pass` */
+static void draw_bloom_blur(sg_pass pass, sg_image src, Vec2 dir) {
+  sg_begin_pass(pass, &(sg_pass_action) {
+    .colors[0] = { .action = SG_ACTION_DONTCARE }
+  });
+  sg_apply_pipeline(state->bloom.blur_pip);
+  sg_apply_bindings(&(sg_bindings) {
+    .vertex_buffers[0] = state->fsq.quad_vbuf,
+    .fs_images[SLOT_tex] = src,
+  });
+  blur_fs_params_t fs_params = state->bloom.blur_params;
+  fs_params.dir = dir;
+  sg_apply_uniforms(SG_SHADERSTAGE_FS, SLOT_blur_fs_params, &SG_RANGE(fs_params));
+  sg_draw(0, 4, 1);
+  sg_end_pass();
 }
 
-static void draw_ent(Mat4 vp, Ent *ent) {
-  if (ent->art == Art_Pillar) {
-    Ent copy = *ent;
-    copy.height = 2;
-    draw_ent_internal(vp, &copy);
-    copy.x_rot = PI_f;
-    copy.height = -4;
-    copy.angle = -copy.angle;
-    draw_ent_internal(vp, &copy);
+/* Blurs the bright target into state->bloom.imgs[0]. The chain is walked down
+ * to the smallest level, then back up, each level accumulating the blurred
+ * result of the one below it. */
+static void draw_bloom(void) {
+  state->bloom.fetches = 0;
+
+  for (int i = 0; i < state->bloom.levels; i++) {
+    sg_begin_pass(state->bloom.passes[i], &(sg_pass_action) {
+      .colors[0] = { .action = SG_ACTION_DONTCARE }
+    });
+    sg_apply_pipeline(state->bloom.down_pip);
+    sg_apply_bindings(&(sg_bindings) {
+      .vertex_buffers[0] = state->fsq.quad_vbuf,
+      .fs_images[SLOT_tex] = i ? state->bloom.imgs[i - 1] : state->offscreen.bright_img,
+    });
+    sg_draw(0, 4, 1);
+    sg_end_pass();
+    state->bloom.fetches += (uint64_t)state->bloom.pixels[i] * BLOOM_DOWN_TAPS;
   }
-  else
-    draw_ent_internal(vp, ent);
+
+  if (state->bloom.filter == BloomFilter_Gaussian)
+    for (int i = 0; i < state->bloom.levels; i++) {
+      draw_bloom_blur(state->bloom.blur_passes[i], state->bloom.imgs[i], vec2(1.0f, 0.0f));
+      draw_bloom_blur(state->bloom.passes[i], state->bloom.blur_imgs[i], vec2(0.0f, 1.0f));
+      state->bloom.fetches += (uint64_t)state->bloom.pixels[i] * BLOOM_BLUR_TAPS * 2;
+    }
+
+  for (int i = state->bloom.levels - 2; i >= 0; i--) {
+    sg_begin_pass(state->bloom.passes[i], &(sg_pass_action) {
+      .colors[0] = { .action = SG_ACTION_LOAD }
+    });
+    sg_apply_pipeline(state->bloom.up_pip);
+    sg_apply_bindings(&(sg_bindings) {
+      .vertex_buffers[0] = state->fsq.quad_vbuf,
+      .fs_images[SLOT_tex] = state->bloom.imgs[i + 1],
+    });
+    sg_draw(0, 4, 1);
+    sg_end_pass();
+    state->bloom.fetches += (uint64_t)state->bloom.pixels[i] * BLOOM_UP_TAPS;
+  }
+}
+
+/* entity slots each tick job handles, see job_parallel_for */
+#define TICK_GRAIN (256)
+#define SUCK_DIST (6.0f)
+
+/* Moves every entity in its slice, removing projectiles that wore out */
+static void tick_movement(void *arg, size_t begin, size_t end) {
+  (void)arg;
+  for (Ent *ent = state->ents + begin; ent < state->ents + end; ent++)
+    if (has_ent_prop(ent, EntProp_Active))
+      collision_movement_update(ent);
+}
+
+/* Pulls pickups toward the player, who has already moved, and counts the
+ * ones that reached it into the long at `arg` */
+static void tick_pickups(void *arg, size_t begin, size_t end) {
+  Ent *p = try_gendex(state->player);
+  long collected = 0;
+  for (Ent *ent = state->ents + begin; ent < state->ents + end; ent++) {
+    if (!has_ent_prop(ent, EntProp_Active) || !has_ent_prop(ent, EntProp_PickUp)) continue;
+
+    ent->height = sinf(ent->pos.x + ent->pos.y + (float) state->tick / 14.0) * 0.3f;
+    if (p!=NULL&&ent->pick_up_after_tick <= state->tick) {
+      Vec2 delta = sub2(p->pos, ent->pos);
+      float dist = mag2(delta);
+
+      if (dist < 0.3f) {
+        collected += 1;
+        remove_ent(ent);
+      }
+      else if (dist < SUCK_DIST)
+        ent->pos = add2(
+          ent->pos,
+          mul2_f(norm2(delta), (SUCK_DIST - dist) / 20.0f)
+        );
+    }
+  }
+  if (collected > 0)
+    job_atomic_add((long*)arg, collected);
+}
+
+static void tick_destruction(void *arg, size_t begin, size_t end) {
+  (void)arg;
+  for (Ent *ent = state->ents + begin; ent < state->ents + end; ent++)
+    if (has_ent_prop(ent, EntProp_Active) && has_ent_prop(ent, EntProp_Destructible) && ent->health <= 0)
+      remove_ent(ent);
 }
 
+/* The stages run one after another, each waiting for the one before. Those
+ * that only write the entity they're looking at are split across the job
+ * threads, as are deciding what the AI does and finding collisions, see
+ * ai_tick and collision_tick. What the stages spawn and what the removed
+ * entities split into is added by flush_ents, once the AI has fired and
+ * the dead are gone, so that it collides this tick, and at the end. */
 static void tick(void) {
   state->tick++;
 
@@ -697,48 +1255,28 @@ static void tick(void) {
   if(player!=NULL)
     player_update(player);
 
-  for (Ent *ent = 0; (ent = ent_all_iter(ent));) {
-    if(has_ent_prop(ent,EntProp_HasAI))
-      ai_run(ent);
+  ai_tick();
+  //TODO: handle loot
+  job_for(tick_destruction, NULL, STATE_MAX_ENTS, TICK_GRAIN);
+  flush_ents();
 
-    if(has_ent_prop(ent, EntProp_Destructible)&&ent->health <= 0) {
-      remove_ent(ent);
-      //TODO: handle loot and asteroid splitting
-    }
-  }
+  collision_tick();
 
-  for (Ent *ent = 0; (ent = ent_all_iter(ent));)
-    collision(ent);
-  for (Ent *ent = 0; (ent = ent_all_iter(ent));) {
-    collision_movement_update(ent);
-
-    if (has_ent_prop(ent, EntProp_PickUp)) {
-      ent->height = sinf(ent->pos.x + ent->pos.y + (float) state->tick / 14.0) * 0.3f;
-      Ent *p = try_gendex(state->player);
-      if (p!=NULL&&ent->pick_up_after_tick <= state->tick) {
-
-        #define SUCK_DIST (6.0f)
-        Vec2 delta = sub2(p->pos, ent->pos);
-        float dist = mag2(delta);
-        
+  job_for(tick_movement, NULL, STATE_MAX_ENTS, TICK_GRAIN);
 
-        if (dist < 0.3f) {
-          state->gem_count += 1;
-          take_ent_prop(ent, EntProp_Active);
-        }
-        if (dist < 0.3f)
-          remove_ent(ent);
-        else if (dist < SUCK_DIST)
-          ent->pos = add2(
-            ent->pos,
-            mul2_f(norm2(delta), (SUCK_DIST - dist) / 20.0f)
-          );
-      }
-    }
-  }
+  long collected = 0;
+  job_for(tick_pickups, &collected, STATE_MAX_ENTS, TICK_GRAIN);
+  state->gem_count += (size_t)collected;
+  flush_ents();
 }
 
 static void frame(void) {
+  worker_finish();
+#ifndef NDEBUG
+  for (const char *path; (path = watch_next()) != NULL;)
+    reload_asset(path);
+#endif
+
   #define TICK_MS (1000.0f / 60.0f)
   double elapsed = stm_ms(stm_laptime(&state->frame));
   state->fixed_tick_accumulator += elapsed;
@@ -749,7 +1287,7 @@ static void frame(void) {
 
   const float w = sapp_widthf();
   const float h = sapp_heightf();
-  Mat4 proj = perspective4x4(1.047f, w/h, 0.01f, 100.0f);
+  Mat4 proj = perspective4x4(CAM_FOV, w/h, 0.01f, 100.0f);
 
   static float cam_angle = 0.0f;
   cam_angle = lerp(cam_angle, state->player.index->angle, 0.08);
@@ -785,15 +1323,15 @@ static void frame(void) {
   }
   qsort(state->cam_ents, cam_ent_count, sizeof(CamEnt), cam_ent_cmp);
 
-  Shader shd = -1;
+  sg_pipeline pip = { 0 };
   for (int i = 0; i < cam_ent_count; i++) {
     Ent *ent = state->ents + state->cam_ents[i].index;
-    Shader ent_shd = state->meshes[ent->art].shader;
-    if (ent_shd != shd) {
-      shd = ent_shd;
-      sg_apply_pipeline(state->pip[shd]);
+    sg_pipeline ent_pip = mesh_pipeline(state->meshes + ent->art);
+    if (ent_pip.id != pip.id) {
+      pip = ent_pip;
+      sg_apply_pipeline(pip);
     }
-    draw_ent(vp, ent);
+    draw_ent(vp, ent, state->cam_ents[i].cam_dist);
   }
 
   float plr_hp = 0.0;
@@ -829,7 +1367,14 @@ static void frame(void) {
       ui_screen_end();
     ui_column_end();
     ui_screen_anchor_xy(0.02, 0.02);
-    ui_textf("FPS: %.0lf", round(1000/elapsed));
+    ui_column(400, 0);
+      ui_textf("FPS: %.0lf", round(1000/elapsed));
+      #ifndef NDEBUG
+        ui_font_size(20);
+        ui_textf("Bloom: %.2fM fetches", (double)state->bloom.fetches / 1e6);
+        ui_font_size(ASSET_FONT_SIZE);
+      #endif
+    ui_column_end();
   ui_screen_end();
 
   build_draw();
@@ -853,23 +1398,7 @@ static void frame(void) {
 
   sg_end_pass();
 
-  for (int i = 0; i < BLUR_PASSES; i++)
-    for (int hori = 0; hori < 2; hori++) {
-      sg_begin_pass(state->blur.passes[i][hori], &(sg_pass_action) {
-        .colors[0] = { .action = SG_ACTION_LOAD }
-      });
-      sg_apply_pipeline(state->blur.pip);
-      sg_apply_bindings(&(sg_bindings) {
-        .vertex_buffers[0] = state->fsq.quad_vbuf,
-        .fs_images = {
-          [SLOT_tex] = hori ? state->blur.imgs[i][!hori] : state->offscreen.bright_img
-        }
-      });
-      blur_fs_params_t fs_params = { .hori = vec2(hori, !hori) };
-      sg_apply_uniforms(SG_SHADERSTAGE_FS, SLOT_blur_fs_params, &SG_RANGE(fs_params));
-      sg_draw(0, 4, 1);
-      sg_end_pass();
-    }
+  draw_bloom();
 
   sg_pass_action pass_action = {
     .colors[0] = { .action = SG_ACTION_CLEAR, .value = { 0.0f, 0.0f, 0.0f, 1.0f } }
@@ -880,10 +1409,7 @@ static void frame(void) {
     .vertex_buffers[0] = state->fsq.quad_vbuf,
     .fs_images = {
       [SLOT_tex] = state->offscreen.color_img,
-      [SLOT_blur0] = state->blur.imgs[0][1],
-      [SLOT_blur1] = state->blur.imgs[1][1],
-      [SLOT_blur2] = state->blur.imgs[2][1],
-      [SLOT_blur3] = state->blur.imgs[3][1],
+      [SLOT_bloom] = state->bloom.imgs[0],
     }
   });
   sg_draw(0, 4, 1);
@@ -895,6 +1421,11 @@ static void frame(void) {
 }
 
 static void cleanup(void) {
+#ifndef NDEBUG
+  watch_shutdown();
+#endif
+  job_shutdown();
+  worker_shutdown();
   sg_shutdown();
 }
 
@@ -907,6 +1438,14 @@ static void event(const sapp_event *ev) {
       #ifndef NDEBUG
         if (ev->key_code == SAPP_KEYCODE_ESCAPE)
           sapp_request_quit();
+        if (ev->key_code == SAPP_KEYCODE_F3) {
+          state->bloom.quality = (state->bloom.quality + 1) % BloomQuality_COUNT;
+          resize_framebuffers();
+        }
+        if (ev->key_code == SAPP_KEYCODE_F4) {
+          state->bloom.filter = (state->bloom.filter + 1) % BloomFilter_COUNT;
+          resize_framebuffers();
+        }
       #endif
     } break;
     case SAPP_EVENTTYPE_MOUSE_MOVE: {
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Binary cache of a fully processed mesh, laid out exactly as the GPU wants it:
+ *   mcache_Header | vertex_count mcache_Vertex | index_count indices of index_size bytes
+ * The header's hash covers everything the mesh was built from, a cache whose
+ * hash doesn't match is stale and simply gets rebuilt and overwritten. */
+
+#define MCACHE_MAGIC   (0x3148534du) /* "MSH1" */
+#define MCACHE_VERSION (4u)
+#define MCACHE_MAX_LODS (8)
+#define MCACHE_HASH_SEED (0xcbf29ce484222325ull)
+/* makes mcache_open accept whatever the file was built from */
+#define MCACHE_ANY_HASH (0ull)
+
+/* Quantized vertex, half the size of the 8 floats obj_unroll_pun produces.
+ * position and uv are unorm16 spanning the header's bounds and uv ranges,
+ * normal is octahedral encoded as snorm16. Decoded by the mesh vertex shaders. */
+typedef struct {
+  uint16_t position[4];
+  uint16_t uv[2];
+  int16_t normal[2];
+} mcache_Vertex;
+
+typedef struct {
+  uint32_t index_offset, index_count;
+  float error;
+} mcache_Lod;
+
+typedef struct {
+  uint32_t magic, version;
+  uint64_t hash;
+  uint32_t vertex_count, index_count;
+  /* bytes per vertex, sizeof(mcache_Vertex) */
+  uint32_t stride;
+  /* bytes per index, 2 or 4 */
+  uint32_t index_size;
+  uint32_t lod_count;
+  mcache_Lod lods[MCACHE_MAX_LODS];
+  float bounds_min[3], bounds_max[3];
+  float uv_min[2], uv_max[2];
+} mcache_Header;
+
+typedef struct {
+  const mcache_Header *header;
+  const mcache_Vertex *vertices;
+  const void *indices;
+  fio_Map _map;
+} mcache_File;
+
+/* FNV-1a, chain calls by passing the previous result as `hash` */
+__attribute__((unused))
+static uint64_t mcache_hash(const void *data, size_t size, uint64_t hash) {
+  const uint8_t *bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < size; i += 1) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static size_t _mcache_expected_size(const mcache_Header *h) {
+  return sizeof(mcache_Header) + (size_t)h->vertex_count*h->stride + (size_t)h->index_count*h->index_size;
+}
+
+__attribute__((unused))
+static void mcache_close(mcache_File *file) {
+  fio_unmap(&file->_map);
+  *file = (mcache_File) { 0 };
+}
+
+/* Maps the cache at `path` if it exists and was built from content hashing to `hash`,
+ * or from anything with MCACHE_ANY_HASH */
+__attribute__((unused))
+static bool mcache_open(const char *path, uint64_t hash, mcache_File *file) {
+  *file = (mcache_File) { 0 };
+  if (!fio_map(path, &file->_map)) return false;
+
+  const mcache_Header *h = (const mcache_Header*)file->_map.data;
+  if (file->_map.size < sizeof(mcache_Header) ||
+      h->magic != MCACHE_MAGIC || h->version != MCACHE_VERSION || (hash != MCACHE_ANY_HASH && h->hash != hash) ||
+      h->lod_count > MCACHE_MAX_LODS || h->stride != sizeof(mcache_Vertex) || (h->index_size != 2 && h->index_size != 4) || _mcache_expected_size(h) != file->_map.size) {
+    mcache_close(file);
+    return false;
+  }
+  file->header = h;
+  file->vertices = (const mcache_Vertex*)(h + 1);
+  file->indices = file->vertices + h->vertex_count;
+  return true;
+}
+
+/* Writes to a temporary file first so a crash never leaves a torn cache behind */
+__attribute__((unused))
+static bool mcache_save(const char *path, const mcache_Header *header, const mcache_Vertex *vertices, const void *indices) {
+  char tmp[512];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  FILE *f = fopen(tmp, "wb");
+  if (f == NULL) return false;
+  mcache_Header h = *header;
+  h.magic = MCACHE_MAGIC;
+  h.version = MCACHE_VERSION;
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+            fwrite(vertices, h.stride, h.vertex_count, f) == h.vertex_count &&
+            fwrite(indices, h.index_size, h.index_count, f) == h.index_count;
+  ok = fclose(f) == 0 && ok;
+#ifdef _WIN32
+  /* rename doesn't replace an existing file on windows */
+  remove(path);
+#endif
+  if (!ok || rename(tmp, path) != 0) {
+    remove(tmp);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,566 @@
+/* Load-time processing of indexed triangle lists.
+ * Vertices are opaque float arrays `stride` floats apart; the first three
+ * floats of every vertex are its position. */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -- Vertex welding --
+
+/* Finds, for every vertex, the first vertex whose first `count` floats are
+ * bitwise identical to it. Writes that vertex's index into `remap`. */
+static void _meshopt_weld(uint32_t *remap, const float *vertices, size_t vertex_count,
+                          size_t stride, size_t count) {
+  size_t cap = 1;
+  while (cap < vertex_count*2) cap *= 2;
+  uint32_t *table = (uint32_t*)malloc(cap*sizeof(uint32_t));
+  memset(table, 0xff, cap*sizeof(uint32_t));
+
+  for (size_t i = 0; i < vertex_count; i += 1) {
+    const float *v = vertices + i*stride;
+    /* FNV-1a over the raw bytes of the floats */
+    uint32_t hash = 2166136261u;
+    const uint8_t *bytes = (const uint8_t*)v;
+    for (size_t b = 0; b < count*sizeof(float); b += 1)
+      hash = (hash ^ bytes[b]) * 16777619u;
+
+    size_t slot = hash & (cap-1);
+    while (table[slot] != UINT32_MAX &&
+           memcmp(vertices + table[slot]*stride, v, count*sizeof(float)) != 0)
+      slot = (slot + 1) & (cap-1);
+
+    if (table[slot] == UINT32_MAX)
+      table[slot] = (uint32_t)i;
+    remap[i] = table[slot];
+  }
+  free(table);
+}
+
+// -- Quadrics --
+
+/* Symmetric 4x4 matrix measuring the summed, area weighted squared distance
+ * of a point to a set of planes; `w` is the total weight. */
+typedef struct {
+  float a2, b2, c2, d2;
+  float ab, ac, ad, bc, bd, cd;
+  float w;
+} _meshopt_Quadric;
+
+static _meshopt_Quadric _meshopt_quadric_plane(Vec3 n, float d, float w) {
+  return (_meshopt_Quadric) {
+    .a2 = w*n.x*n.x, .b2 = w*n.y*n.y, .c2 = w*n.z*n.z, .d2 = w*d*d,
+    .ab = w*n.x*n.y, .ac = w*n.x*n.z, .ad = w*n.x*d,
+    .bc = w*n.y*n.z, .bd = w*n.y*d,   .cd = w*n.z*d,
+    .w = w,
+  };
+}
+
+static void _meshopt_quadric_add(_meshopt_Quadric *q, const _meshopt_Quadric *r) {
+  q->a2 += r->a2; q->b2 += r->b2; q->c2 += r->c2; q->d2 += r->d2;
+  q->ab += r->ab; q->ac += r->ac; q->ad += r->ad;
+  q->bc += r->bc; q->bd += r->bd; q->cd += r->cd;
+  q->w  += r->w;
+}
+
+/* mean squared distance from `p` to the planes accumulated in `q` */
+static float _meshopt_quadric_error(const _meshopt_Quadric *q, Vec3 p) {
+  float e = q->a2*p.x*p.x + q->b2*p.y*p.y + q->c2*p.z*p.z + q->d2
+          + 2.0f*(q->ab*p.x*p.y + q->ac*p.x*p.z + q->bc*p.y*p.z)
+          + 2.0f*(q->ad*p.x + q->bd*p.y + q->cd*p.z);
+  e = e < 0.0f ? 0.0f : e;
+  return q->w > 0.0f ? e / q->w : e;
+}
+
+// -- Simplification --
+
+typedef struct {
+  uint32_t from, to;
+  float cost;
+} _meshopt_Collapse;
+
+static int _meshopt_collapse_cmp(const void *av, const void *bv) {
+  float a = ((const _meshopt_Collapse*)av)->cost;
+  float b = ((const _meshopt_Collapse*)bv)->cost;
+  return (a > b) - (a < b);
+}
+
+typedef struct {
+  const float *vertices;
+  size_t stride;
+  /* vertex -> first vertex sharing its position */
+  uint32_t *pos;
+  /* triangles touching each position, CSR style */
+  uint32_t *adj_offset, *adj;
+} _meshopt_Topology;
+
+static inline Vec3 _meshopt_position(const _meshopt_Topology *t, uint32_t v) {
+  const float *p = t->vertices + v*t->stride;
+  return vec3(p[0], p[1], p[2]);
+}
+
+static void _meshopt_build_adjacency(_meshopt_Topology *t, const uint32_t *tris,
+                                     size_t tri_count, size_t vertex_count) {
+  memset(t->adj_offset, 0, (vertex_count+1)*sizeof(uint32_t));
+  for (size_t i = 0; i < tri_count*3; i += 1)
+    t->adj_offset[t->pos[tris[i]]+1] += 1;
+  for (size_t i = 0; i < vertex_count; i += 1)
+    t->adj_offset[i+1] += t->adj_offset[i];
+  for (size_t i = 0; i < tri_count*3; i += 1) {
+    uint32_t p = t->pos[tris[i]];
+    t->adj[t->adj_offset[p]++] = (uint32_t)(i/3);
+  }
+  /* the fill loop advanced every offset to the start of the next list */
+  for (size_t i = vertex_count; i > 0; i -= 1)
+    t->adj_offset[i] = t->adj_offset[i-1];
+  t->adj_offset[0] = 0;
+}
+
+/* Checks that every vertex of position `from` shares an edge with exactly one
+ * vertex of position `to`, so that attribute seams survive the collapse, and
+ * writes that pairing into `pair_from`/`pair_to`. Returns the pair count or 0. */
+static size_t _meshopt_seam_pairs(const _meshopt_Topology *t, const uint32_t *tris,
+                                  uint32_t from, uint32_t to,
+                                  uint32_t *pair_from, uint32_t *pair_to, size_t max_pairs) {
+  size_t pairs = 0;
+  /* first collect every distinct vertex of `from` */
+  for (uint32_t a = t->adj_offset[from]; a < t->adj_offset[from+1]; a += 1) {
+    const uint32_t *tri = tris + t->adj[a]*3;
+    for (int k = 0; k < 3; k += 1) {
+      if (t->pos[tri[k]] != from) continue;
+      size_t j = 0;
+      while (j < pairs && pair_from[j] != tri[k]) j += 1;
+      if (j == pairs) {
+        if (pairs == max_pairs) return 0;
+        pair_from[pairs] = tri[k];
+        pair_to[pairs] = UINT32_MAX;
+        pairs += 1;
+      }
+    }
+  }
+  /* then find which vertex of `to` each of them is connected to */
+  for (uint32_t a = t->adj_offset[from]; a < t->adj_offset[from+1]; a += 1) {
+    const uint32_t *tri = tris + t->adj[a]*3;
+    uint32_t vf = UINT32_MAX, vt = UINT32_MAX;
+    for (int k = 0; k < 3; k += 1) {
+      if (t->pos[tri[k]] == from) vf = tri[k];
+      if (t->pos[tri[k]] == to)   vt = tri[k];
+    }
+    if (vt == UINT32_MAX) continue;
+    for (size_t j = 0; j < pairs; j += 1)
+      if (pair_from[j] == vf) {
+        if (pair_to[j] != UINT32_MAX && pair_to[j] != vt) return 0;
+        pair_to[j] = vt;
+      }
+  }
+  for (size_t j = 0; j < pairs; j += 1)
+    if (pair_to[j] == UINT32_MAX) return 0;
+  return pairs;
+}
+
+/* Moving position `from` onto `to` must not fold any surviving triangle over */
+static bool _meshopt_collapse_flips(const _meshopt_Topology *t, const uint32_t *tris,
+                                    uint32_t from, uint32_t to) {
+  Vec3 target = _meshopt_position(t, to);
+  for (uint32_t a = t->adj_offset[from]; a < t->adj_offset[from+1]; a += 1) {
+    const uint32_t *tri = tris + t->adj[a]*3;
+    Vec3 p[3], q[3];
+    bool removed = false;
+    for (int k = 0; k < 3; k += 1) {
+      uint32_t pk = t->pos[tri[k]];
+      removed |= pk == to;
+      p[k] = _meshopt_position(t, tri[k]);
+      q[k] = pk == from ? target : p[k];
+    }
+    if (removed) continue;
+    Vec3 n0 = cross3(sub3(p[1], p[0]), sub3(p[2], p[0]));
+    Vec3 n1 = cross3(sub3(q[1], q[0]), sub3(q[2], q[0]));
+    /* reject anything rotating a face by more than ~75 degrees */
+    if (dot3(n0, n1) <= 0.25f * mag3(n0) * mag3(n1))
+      return true;
+  }
+  return false;
+}
+
+#define _MESHOPT_MAX_SEAM (16)
+
+/* Simplifies the triangle list `indices` down to about `target_index_count`
+ * indices by repeatedly collapsing the cheapest edges, as measured by their
+ * quadric error. No vertices are created or moved, so the result indexes the
+ * same vertex buffer. Vertices on open borders are never moved and vertices
+ * on UV/normal seams only slide along their seam.
+ *
+ * `dest` must have room for `index_count` indices. The largest distance a
+ * vertex ended up from the plane of an original triangle it was a corner of
+ * is stored into `error`. Returns the new index count. */
+__attribute__((unused))
+static size_t meshopt_simplify(uint32_t *dest, const uint32_t *indices, size_t index_count,
+                               const float *vertices, size_t vertex_count, size_t stride,
+                               size_t target_index_count, float *error) {
+  _meshopt_Topology t = {
+    .vertices = vertices,
+    .stride = stride,
+    .pos = (uint32_t*)malloc(vertex_count*sizeof(uint32_t)),
+    .adj_offset = (uint32_t*)malloc((vertex_count+1)*sizeof(uint32_t)),
+    .adj = (uint32_t*)malloc(index_count*sizeof(uint32_t)),
+  };
+  uint32_t *attr   = (uint32_t*)malloc(vertex_count*sizeof(uint32_t));
+  uint32_t *tris   = (uint32_t*)malloc(index_count*sizeof(uint32_t));
+  uint32_t *remap  = (uint32_t*)malloc(vertex_count*sizeof(uint32_t));
+  /* the vertex each one was collapsed into, over all passes */
+  uint32_t *root   = (uint32_t*)malloc(vertex_count*sizeof(uint32_t));
+  uint8_t  *locked = (uint8_t*)calloc(vertex_count, 1);
+  uint8_t  *dirty  = (uint8_t*)malloc(vertex_count);
+  _meshopt_Quadric *quadrics = (_meshopt_Quadric*)calloc(vertex_count, sizeof(_meshopt_Quadric));
+  _meshopt_Collapse *collapses = (_meshopt_Collapse*)malloc(index_count*sizeof(_meshopt_Collapse));
+
+  /* vertices are matched by their whole contents, positions by position only */
+  _meshopt_weld(attr, vertices, vertex_count, stride, stride);
+  _meshopt_weld(t.pos, vertices, vertex_count, stride, 3);
+  size_t tri_count = 0;
+  for (size_t i = 0; i < index_count; i += 3) {
+    uint32_t a = attr[indices[i]], b = attr[indices[i+1]], c = attr[indices[i+2]];
+    if (t.pos[a] == t.pos[b] || t.pos[b] == t.pos[c] || t.pos[c] == t.pos[a])
+      continue;
+    tris[tri_count*3+0] = a;
+    tris[tri_count*3+1] = b;
+    tris[tri_count*3+2] = c;
+    tri_count += 1;
+  }
+  size_t source_count = tri_count;
+  uint32_t *source = (uint32_t*)malloc(tri_count*3*sizeof(uint32_t));
+  memcpy(source, tris, tri_count*3*sizeof(uint32_t));
+  for (uint32_t i = 0; i < vertex_count; i += 1)
+    root[i] = i;
+
+  for (size_t i = 0; i < tri_count; i += 1) {
+    Vec3 p0 = _meshopt_position(&t, tris[i*3+0]);
+    Vec3 p1 = _meshopt_position(&t, tris[i*3+1]);
+    Vec3 p2 = _meshopt_position(&t, tris[i*3+2]);
+    Vec3 n = cross3(sub3(p1, p0), sub3(p2, p0));
+    float area = mag3(n);
+    if (area == 0.0f) continue;
+    n = div3_f(n, area);
+    _meshopt_Quadric q = _meshopt_quadric_plane(n, -dot3(n, p0), area * 0.5f);
+    for (size_t k = 0; k < 3; k += 1)
+      _meshopt_quadric_add(&quadrics[t.pos[tris[i*3+k]]], &q);
+  }
+
+  /* an edge shared by anything other than two triangles is a border */
+  _meshopt_build_adjacency(&t, tris, tri_count, vertex_count);
+  for (uint32_t p = 0; p < vertex_count; p += 1) {
+    if (t.pos[p] != p) continue;
+    for (uint32_t a = t.adj_offset[p]; a < t.adj_offset[p+1] && !locked[p]; a += 1)
+      for (uint32_t k = 0; k < 3; k += 1) {
+        uint32_t q = t.pos[tris[t.adj[a]*3+k]];
+        if (q == p) continue;
+        int shared = 0;
+        for (uint32_t b = t.adj_offset[p]; b < t.adj_offset[p+1]; b += 1)
+          for (uint32_t l = 0; l < 3; l += 1)
+            shared += t.pos[tris[t.adj[b]*3+l]] == q;
+        if (shared != 2) locked[p] = 1;
+      }
+  }
+
+  while (tri_count*3 > target_index_count) {
+    _meshopt_build_adjacency(&t, tris, tri_count, vertex_count);
+
+    size_t collapse_count = 0;
+    for (size_t i = 0; i < tri_count; i += 1)
+      for (size_t k = 0; k < 3; k += 1) {
+        uint32_t from = t.pos[tris[i*3+k]], to = t.pos[tris[i*3+(k+1)%3]];
+        if (locked[from]) continue;
+        _meshopt_Quadric q = quadrics[from];
+        _meshopt_quadric_add(&q, &quadrics[to]);
+        collapses[collapse_count++] = (_meshopt_Collapse) {
+          .from = from,
+          .to = to,
+          .cost = _meshopt_quadric_error(&q, _meshopt_position(&t, to)),
+        };
+      }
+    qsort(collapses, collapse_count, sizeof(_meshopt_Collapse), _meshopt_collapse_cmp);
+
+    for (uint32_t i = 0; i < vertex_count; i += 1)
+      remap[i] = i;
+    memset(dirty, 0, vertex_count);
+
+    /* every collapse removes about two triangles; only ever touch a
+     * neighbourhood once per pass so the checks above stay valid */
+    size_t removed = 0, performed = 0;
+    for (size_t c = 0; c < collapse_count; c += 1) {
+      if ((tri_count - removed)*3 <= target_index_count) break;
+      _meshopt_Collapse *cl = collapses + c;
+      if (dirty[cl->from] || dirty[cl->to]) continue;
+
+      uint32_t pair_from[_MESHOPT_MAX_SEAM], pair_to[_MESHOPT_MAX_SEAM];
+      size_t pairs = _meshopt_seam_pairs(&t, tris, cl->from, cl->to,
+                                         pair_from, pair_to, _MESHOPT_MAX_SEAM);
+      if (pairs == 0 || _meshopt_collapse_flips(&t, tris, cl->from, cl->to))
+        continue;
+
+      for (size_t j = 0; j < pairs; j += 1)
+        remap[pair_from[j]] = pair_to[j];
+      _meshopt_quadric_add(&quadrics[cl->to], &quadrics[cl->from]);
+
+      for (uint32_t a = t.adj_offset[cl->from]; a < t.adj_offset[cl->from+1]; a += 1) {
+        const uint32_t *tri = tris + t.adj[a]*3;
+        bool shared = false;
+        for (int k = 0; k < 3; k += 1) {
+          dirty[t.pos[tri[k]]] = 1;
+          shared |= t.pos[tri[k]] == cl->to;
+        }
+        removed += shared;
+      }
+      performed += 1;
+    }
+    if (performed == 0) break;
+    for (uint32_t i = 0; i < vertex_count; i += 1)
+      root[i] = remap[root[i]];
+
+    size_t kept = 0;
+    for (size_t i = 0; i < tri_count; i += 1) {
+      uint32_t a = remap[tris[i*3+0]], b = remap[tris[i*3+1]], c = remap[tris[i*3+2]];
+      if (t.pos[a] == t.pos[b] || t.pos[b] == t.pos[c] || t.pos[c] == t.pos[a])
+        continue;
+      tris[kept*3+0] = a;
+      tris[kept*3+1] = b;
+      tris[kept*3+2] = c;
+      kept += 1;
+    }
+    tri_count = kept;
+  }
+
+  for (size_t i = 0; i < tri_count*3; i += 1)
+    dest[i] = tris[i];
+  /* the quadrics only average these distances, which understates how far
+   * the surface moved wherever a collapse folds it over a sharp edge */
+  if (error != NULL) {
+    float max_dist = 0.0f;
+    for (size_t i = 0; i < source_count; i += 1) {
+      Vec3 p0 = _meshopt_position(&t, source[i*3+0]);
+      Vec3 n = cross3(sub3(_meshopt_position(&t, source[i*3+1]), p0),
+                      sub3(_meshopt_position(&t, source[i*3+2]), p0));
+      float len = mag3(n);
+      if (len == 0.0f) continue;
+      n = div3_f(n, len);
+      for (size_t k = 0; k < 3; k += 1) {
+        float dist = fabsf(dot3(n, sub3(_meshopt_position(&t, root[source[i*3+k]]), p0)));
+        max_dist = dist > max_dist ? dist : max_dist;
+      }
+    }
+    *error = max_dist;
+  }
+
+  free(t.pos);
+  free(t.adj_offset);
+  free(t.adj);
+  free(attr);
+  free(tris);
+  free(remap);
+  free(root);
+  free(source);
+  free(locked);
+  free(dirty);
+  free(quadrics);
+  free(collapses);
+  return tri_count*3;
+}
+
+#undef _MESHOPT_MAX_SEAM
+
+// -- Vertex cache --
+
+/* FIFO size of the post-transform cache we optimize for and measure against */
+#define MESHOPT_CACHE_SIZE (16)
+
+/* Average cache miss ratio: vertex shader runs per triangle when drawn through
+ * a MESHOPT_CACHE_SIZE entry FIFO cache. 3.0 is the worst, ~0.5 the best. */
+__attribute__((unused))
+static float meshopt_acmr(const uint32_t *indices, size_t index_count) {
+  uint32_t cache[MESHOPT_CACHE_SIZE];
+  size_t head = 0, misses = 0;
+  memset(cache, 0xff, sizeof(cache));
+
+  for (size_t i = 0; i < index_count; i += 1) {
+    bool hit = false;
+    for (int c = 0; c < MESHOPT_CACHE_SIZE; c += 1)
+      hit |= cache[c] == indices[i];
+    if (hit) continue;
+    cache[head] = indices[i];
+    head = (head + 1) % MESHOPT_CACHE_SIZE;
+    misses += 1;
+  }
+  return index_count ? (float)misses / (float)(index_count/3) : 0.0f;
+}
+
+/* Reorders triangles for the post-transform vertex cache using Tipsify
+ * (Sander, Nehab & Barczak, "Fast Triangle Reordering for Vertex Locality and
+ * Reduced Overdraw"): triangles are emitted as fans around a vertex, and the
+ * next fan is chosen among recently emitted vertices still in the cache.
+ *
+ * Whenever the fanning has to jump to an unrelated part of the mesh, a new
+ * cluster starts; the index each cluster starts at is written to `clusters`
+ * (room for index_count/3 entries), ready for meshopt_optimize_overdraw.
+ * Returns the cluster count. */
+__attribute__((unused))
+static size_t meshopt_optimize_vertex_cache(uint32_t *dest, const uint32_t *indices, size_t index_count,
+                                            size_t vertex_count, uint32_t *clusters) {
+  size_t tri_count = index_count/3;
+  uint32_t *live      = (uint32_t*)calloc(vertex_count, sizeof(uint32_t));
+  uint32_t *adj_start = (uint32_t*)calloc(vertex_count+1, sizeof(uint32_t));
+  uint32_t *adj       = (uint32_t*)malloc(index_count*sizeof(uint32_t));
+  uint32_t *cache_at  = (uint32_t*)calloc(vertex_count, sizeof(uint32_t));
+  uint32_t *dead_end  = (uint32_t*)malloc(index_count*sizeof(uint32_t));
+  uint8_t  *emitted   = (uint8_t*)calloc(tri_count, 1);
+
+  for (size_t i = 0; i < index_count; i += 1)
+    live[indices[i]] += 1;
+  for (size_t v = 0; v < vertex_count; v += 1)
+    adj_start[v+1] = adj_start[v] + live[v];
+  /* cache_at doubles as the fill counter while building the adjacency */
+  for (size_t i = 0; i < index_count; i += 1)
+    adj[adj_start[indices[i]] + cache_at[indices[i]]++] = (uint32_t)(i/3);
+  memset(cache_at, 0, vertex_count*sizeof(uint32_t));
+
+  /* a vertex is in the cache if it was last used less than a cache size ago */
+  uint32_t time = MESHOPT_CACHE_SIZE + 1;
+  size_t out = 0, cluster_count = 0, dead_end_top = 0, cursor = 0;
+  int64_t fan = index_count ? (int64_t)indices[0] : -1;
+  bool new_cluster = true;
+
+  while (fan >= 0) {
+    if (new_cluster) clusters[cluster_count++] = (uint32_t)out;
+    size_t first_candidate = dead_end_top;
+
+    for (uint32_t a = adj_start[fan]; a < adj_start[fan+1]; a += 1) {
+      uint32_t t = adj[a];
+      if (emitted[t]) continue;
+      emitted[t] = 1;
+      for (uint32_t k = 0; k < 3; k += 1) {
+        uint32_t v = indices[t*3+k];
+        dest[out++] = v;
+        dead_end[dead_end_top++] = v;
+        live[v] -= 1;
+        if (time - cache_at[v] > MESHOPT_CACHE_SIZE)
+          cache_at[v] = time++;
+      }
+    }
+
+    /* prefer the oldest vertex of this fan that will still be cached once
+     * its remaining triangles have been emitted */
+    int64_t best = -1, best_priority = -1;
+    for (size_t c = first_candidate; c < dead_end_top; c += 1) {
+      uint32_t v = dead_end[c];
+      if (live[v] == 0) continue;
+      int64_t priority = 0;
+      if (time - cache_at[v] + 2*live[v] <= MESHOPT_CACHE_SIZE)
+        priority = time - cache_at[v];
+      if (priority > best_priority) {
+        best = v;
+        best_priority = priority;
+      }
+    }
+    new_cluster = best < 0;
+
+    /* dead end: back out through recently used vertices, then scan the input */
+    while (best < 0 && dead_end_top > 0) {
+      uint32_t v = dead_end[--dead_end_top];
+      if (live[v] > 0) best = v;
+    }
+    while (best < 0 && cursor < index_count) {
+      if (live[indices[cursor]] > 0) best = indices[cursor];
+      cursor += 1;
+    }
+    fan = best;
+  }
+
+  free(live);
+  free(adj_start);
+  free(adj);
+  free(cache_at);
+  free(dead_end);
+  free(emitted);
+  return cluster_count;
+}
+
+typedef struct {
+  uint32_t start, end;
+  float sort;
+} _meshopt_Cluster;
+
+static int _meshopt_cluster_cmp(const void *av, const void *bv) {
+  float a = ((const _meshopt_Cluster*)av)->sort;
+  float b = ((const _meshopt_Cluster*)bv)->sort;
+  return (a < b) - (a > b);
+}
+
+/* Reorders the clusters found by meshopt_optimize_vertex_cache so that the
+ * ones facing away from the mesh's center, which tend to occlude the others,
+ * are drawn first. The order of triangles inside a cluster is kept, so the
+ * cache efficiency barely changes. */
+__attribute__((unused))
+static void meshopt_optimize_overdraw(uint32_t *dest, const uint32_t *indices, size_t index_count,
+                                      const uint32_t *clusters, size_t cluster_count,
+                                      const float *vertices, size_t stride) {
+  _meshopt_Cluster *sorted = (_meshopt_Cluster*)malloc(cluster_count*sizeof(_meshopt_Cluster));
+
+  Vec3 center = vec3_f(0.0f);
+  for (size_t i = 0; i < index_count; i += 1) {
+    const float *p = vertices + indices[i]*stride;
+    center = add3(center, vec3(p[0], p[1], p[2]));
+  }
+  center = div3_f(center, index_count ? (float)index_count : 1.0f);
+
+  for (size_t c = 0; c < cluster_count; c += 1) {
+    _meshopt_Cluster *cl = sorted + c;
+    cl->start = clusters[c];
+    cl->end = (c+1 < cluster_count) ? clusters[c+1] : (uint32_t)index_count;
+
+    Vec3 centroid = vec3_f(0.0f), normal = vec3_f(0.0f);
+    for (uint32_t i = cl->start; i < cl->end; i += 3) {
+      const float *a = vertices + indices[i+0]*stride;
+      const float *b = vertices + indices[i+1]*stride;
+      const float *d = vertices + indices[i+2]*stride;
+      Vec3 p0 = vec3(a[0], a[1], a[2]), p1 = vec3(b[0], b[1], b[2]), p2 = vec3(d[0], d[1], d[2]);
+      /* area weighted, as the cross product's length is twice the area */
+      Vec3 n = cross3(sub3(p1, p0), sub3(p2, p0));
+      normal = add3(normal, n);
+      centroid = add3(centroid, mul3_f(add3(add3(p0, p1), p2), mag3(n)));
+    }
+    float area = mag3(normal);
+    centroid = area > 0.0f ? div3_f(centroid, area * 3.0f) : center;
+    cl->sort = area > 0.0f ? dot3(sub3(centroid, center), div3_f(normal, area)) : 0.0f;
+  }
+  qsort(sorted, cluster_count, sizeof(_meshopt_Cluster), _meshopt_cluster_cmp);
+
+  size_t out = 0;
+  for (size_t c = 0; c < cluster_count; c += 1)
+    for (uint32_t i = sorted[c].start; i < sorted[c].end; i += 1)
+      dest[out++] = indices[i];
+  free(sorted);
+}
+
+/* Reorders vertices into the order they are first used in `indices`, so that
+ * vertex fetches walk memory linearly, and drops unused ones. Rewrites
+ * `indices` in place to match `dest`. Returns the new vertex count. */
+__attribute__((unused))
+static size_t meshopt_optimize_vertex_fetch(float *dest, uint32_t *indices, size_t index_count,
+                                            const float *vertices, size_t vertex_count, size_t stride) {
+  uint32_t *remap = (uint32_t*)malloc(vertex_count*sizeof(uint32_t));
+  memset(remap, 0xff, vertex_count*sizeof(uint32_t));
+
+  size_t next = 0;
+  for (size_t i = 0; i < index_count; i += 1) {
+    uint32_t v = indices[i];
+    if (remap[v] == UINT32_MAX) {
+      remap[v] = (uint32_t)next;
+      memcpy(dest + next*stride, vertices + v*stride, stride*sizeof(float));
+      next += 1;
+    }
+    indices[i] = remap[v];
+  }
+  free(remap);
+  return next;
+}
@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <math.h>
+
+/* Gamma-correct mip chains for RGBA8 textures.
+ *
+ * Each level is a 2x2 box filter of the one above it. Colour is averaged in
+ * linear light, which keeps smaller levels from getting darker the way
+ * averaging the sRGB bytes does. Alpha is averaged as it is. Levels are
+ * filtered from a 14 bit linear copy of the previous level rather than from
+ * its rounded bytes, so rounding errors don't pile up down the chain.
+ *
+ * mip_init has to be called once, on the main thread, before mip_build. */
+
+#define MIP_MAX_LEVELS (16)
+/* linear values have 14 bits, so four of them still sum into a uint16_t */
+#define MIP_LINEAR_MAX (16383)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_SSE2
+#include <emmintrin.h>
+#endif
+
+static struct {
+  bool ready;
+  uint16_t to_linear[256];
+  uint8_t to_srgb[MIP_LINEAR_MAX + 1];
+} _mip_state;
+
+__attribute__((unused))
+static void mip_init(void) {
+  for (int i = 0; i < 256; i++) {
+    double c = i/255.0;
+    double l = c <= 0.04045 ? c/12.92 : pow((c + 0.055)/1.055, 2.4);
+    _mip_state.to_linear[i] = (uint16_t)(l*MIP_LINEAR_MAX + 0.5);
+  }
+  for (int i = 0; i <= MIP_LINEAR_MAX; i++) {
+    double l = (double)i/MIP_LINEAR_MAX;
+    double c = l <= 0.0031308 ? l*12.92 : 1.055*pow(l, 1.0/2.4) - 0.055;
+    _mip_state.to_srgb[i] = (uint8_t)(c*255.0 + 0.5);
+  }
+  _mip_state.ready = true;
+}
+
+/* Levels in a full chain down to 1x1, capped at MIP_MAX_LEVELS */
+__attribute__((unused))
+static size_t mip_count(uint32_t width, uint32_t height) {
+  size_t count = 1;
+  for (uint32_t s = width > height ? width : height; s > 1 && count < MIP_MAX_LEVELS; s /= 2)
+    count++;
+  return count;
+}
+
+/* Bytes taken by the first `count` RGBA8 levels, stored back to back */
+__attribute__((unused))
+static size_t mip_chain_size(uint32_t width, uint32_t height, size_t count) {
+  size_t size = 0;
+  for (size_t i = 0; i < count; i++) {
+    size += (size_t)width*height*4;
+    width = width > 1 ? width/2 : 1;
+    height = height > 1 ? height/2 : 1;
+  }
+  return size;
+}
+
+static uint16_t _mip_alpha_to_linear(uint8_t a) {
+  return (uint16_t)((a*MIP_LINEAR_MAX + 127)/255);
+}
+
+static uint8_t _mip_alpha_to_byte(uint32_t a) {
+  return (uint8_t)((a*255 + MIP_LINEAR_MAX/2)/MIP_LINEAR_MAX);
+}
+
+/* Filters linear level `src` down into `dst`, and its bytes into `out`.
+ * Only a level with a side of 1 has to reuse texels, an odd side simply drops its last row or column. */
+static void _mip_downsample(const uint16_t *src, uint32_t sw, uint32_t sh,
+                            uint16_t *dst, uint8_t *out, uint32_t dw, uint32_t dh) {
+  for (uint32_t y = 0; y < dh; y++) {
+    const uint16_t *row0 = src + (size_t)m_min(y*2, sh-1)*sw*4;
+    const uint16_t *row1 = src + (size_t)m_min(y*2+1, sh-1)*sw*4;
+    uint16_t *d = dst + (size_t)y*dw*4;
+    uint8_t *o = out + (size_t)y*dw*4;
+    uint32_t x = 0;
+
+#ifdef MIP_SSE2
+    /* both texels of a row in one register, the two halves are summed after */
+    if (sw >= 2)
+      for (; x < dw; x++) {
+        __m128i sum = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(row0 + x*8)),
+                                    _mm_loadu_si128((const __m128i*)(row1 + x*8)));
+        sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+        _mm_storel_epi64((__m128i*)(d + x*4), sum);
+      }
+#endif
+    for (; x < dw; x++) {
+      uint32_t x0 = m_min(x*2, sw-1), x1 = m_min(x*2+1, sw-1);
+      for (uint32_t c = 0; c < 4; c++)
+        d[x*4 + c] = (uint16_t)((row0[x0*4 + c] + row0[x1*4 + c] + row1[x0*4 + c] + row1[x1*4 + c] + 2)/4);
+    }
+
+    for (x = 0; x < dw; x++) {
+      o[x*4 + 0] = _mip_state.to_srgb[d[x*4 + 0]];
+      o[x*4 + 1] = _mip_state.to_srgb[d[x*4 + 1]];
+      o[x*4 + 2] = _mip_state.to_srgb[d[x*4 + 2]];
+      o[x*4 + 3] = _mip_alpha_to_byte(d[x*4 + 3]);
+    }
+  }
+}
+
+/* `levels` starts with the width*height RGBA8 base level and has room for
+ * mip_chain_size(width, height, count) bytes, each following level is
+ * written directly after the one it was filtered from */
+__attribute__((unused))
+static void mip_build(uint8_t *levels, uint32_t width, uint32_t height, size_t count) {
+  assert(_mip_state.ready && "mip_init has to be called before mip_build");
+  if (count < 2) return;
+
+  /* the linear copies of the level being read and the one being written */
+  uint32_t w = width, h = height;
+  uint16_t *src = (uint16_t*)malloc((size_t)w*h*4*sizeof(uint16_t));
+  uint16_t *dst = (uint16_t*)malloc((size_t)m_max(w/2, 1u)*m_max(h/2, 1u)*4*sizeof(uint16_t));
+  for (size_t i = 0; i < (size_t)w*h; i++) {
+    src[i*4 + 0] = _mip_state.to_linear[levels[i*4 + 0]];
+    src[i*4 + 1] = _mip_state.to_linear[levels[i*4 + 1]];
+    src[i*4 + 2] = _mip_state.to_linear[levels[i*4 + 2]];
+    src[i*4 + 3] = _mip_alpha_to_linear(levels[i*4 + 3]);
+  }
+
+  uint8_t *level = levels;
+  for (size_t i = 1; i < count; i++) {
+    uint32_t nw = m_max(w/2, 1u), nh = m_max(h/2, 1u);
+    uint8_t *next = level + (size_t)w*h*4;
+    _mip_downsample(src, w, h, dst, next, nw, nh);
+
+    /* every level after the first fits in the space of the one before */
+    uint16_t *swap = src;
+    src = dst;
+    dst = swap;
+    level = next;
+    w = nw;
+    h = nh;
+  }
+  free(src);
+  free(dst);
+}
@@ -4,21 +4,21 @@
 #include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <math.h>
 
 typedef struct {
   const char *src;
 } _obj_Parser;
 
-#define VERTEX_COUNT (1 << 15)
-#define INDEX_COUNT  (1 << 16)
-
-
 typedef struct {
-  uint16_t v;  // Vertex idx
-  uint16_t vt; // Texture idx
-  uint16_t vn; // Normal idx
+  uint32_t v;  // Vertex idx
+  uint32_t vt; // Texture idx
+  uint32_t vn; // Normal idx
 } obj_Triplet;
 
+/* faces with more corners than this are rejected */
+#define OBJ_MAX_CORNERS (256)
+
 // The result for parsing 
 typedef struct {
   size_t vertex_count;
@@ -29,37 +29,44 @@ typedef struct {
   float *normals;
   size_t index_count;
   obj_Triplet *indices;
+  /* what _obj_count found room for, all four arrays share one allocation */
+  size_t _vertex_cap, _uv_cap, _normal_cap, _index_cap;
+  void *_block;
 } obj_Result;
 
 typedef struct {
   float *vertices;
-  uint16_t *indices;
+  uint32_t *indices;
 } obj_Unrolled;
 
 #define Parser _obj_Parser
 #define chk _obj_chk
 #define verify _obj_verify
-#define oneof _obj_oneof
 #define next _obj_next
 
+/* _obj_count sizes these, with NDEBUG whatever doesn't fit is dropped */
 static void _obj_index(obj_Result *self, obj_Triplet index) {
-  assert(self->index_count <= INDEX_COUNT && "Obj: Index buffer overflow");
-  self->indices[self->index_count++] = index;
+  bool fits = self->index_count < self->_index_cap;
+  assert(fits && "Obj: Index buffer overflow");
+  if (fits) self->indices[self->index_count++] = index;
 }
 
 static void _obj_vertex(obj_Result *self, float vertex) {
-  assert(self->vertex_count <= VERTEX_COUNT && "Obj: Vertex buffer overflow");
-  self->vertices[self->vertex_count++] = vertex;
+  bool fits = self->vertex_count < self->_vertex_cap;
+  assert(fits && "Obj: Vertex buffer overflow");
+  if (fits) self->vertices[self->vertex_count++] = vertex;
 }
 
 static void _obj_normal(obj_Result *self, float vertex) {
-  assert(self->normal_count <= VERTEX_COUNT && "Obj: Normal vertex buffer overflow");
-  self->normals[self->normal_count++] = vertex;
+  bool fits = self->normal_count < self->_normal_cap;
+  assert(fits && "Obj: Normal vertex buffer overflow");
+  if (fits) self->normals[self->normal_count++] = vertex;
 }
 
 static void _obj_uv(obj_Result *self, float vertex) {
-  assert(self->uv_count <= VERTEX_COUNT && "Obj: Uv vertex buffer overflow");
-  self->uvs[self->uv_count++] = vertex;
+  bool fits = self->uv_count < self->_uv_cap;
+  assert(fits && "Obj: Uv vertex buffer overflow");
+  if (fits) self->uvs[self->uv_count++] = vertex;
 }
 
 static bool _obj_chk(Parser *self, char c) {
@@ -74,12 +81,6 @@ static bool _obj_verify(Parser *self, const char *s) {
   return false;
 }
 
-static bool _obj_oneof(Parser *self, const char *chars) {
-  for (;*chars; chars += 1)
-    if (chk(self, *chars)) return true;
-  return false;
-}
-
 static char _obj_next(Parser *self) {
   char val = *self->src;
   if (*self->src != 0)
@@ -87,63 +88,120 @@ static char _obj_next(Parser *self) {
   return val;
 }
 
-static bool _obj_empty(Parser *self) {
-  const char *begin = self->src;
-  while (oneof(self, "\n\r\t ")) next(self);
-  return begin != self->src;
+/* character classes, indexed by the unsigned byte */
+enum { _OBJ_SPACE = 1, _OBJ_DIGIT = 2 };
+static const uint8_t _obj_class[256] = {
+  ['\t'] = _OBJ_SPACE, ['\n'] = _OBJ_SPACE, ['\r'] = _OBJ_SPACE, [' '] = _OBJ_SPACE,
+  ['0'] = _OBJ_DIGIT, ['1'] = _OBJ_DIGIT, ['2'] = _OBJ_DIGIT, ['3'] = _OBJ_DIGIT, ['4'] = _OBJ_DIGIT,
+  ['5'] = _OBJ_DIGIT, ['6'] = _OBJ_DIGIT, ['7'] = _OBJ_DIGIT, ['8'] = _OBJ_DIGIT, ['9'] = _OBJ_DIGIT,
+};
+
+static inline bool _obj_isdigit(char c) {
+  return _obj_class[(uint8_t)c] & _OBJ_DIGIT;
 }
 
-static bool _obj_comment(Parser *self) {
-  const char *begin = self->src;
-  if (chk(self, '#')) {
-    do next(self); while (!chk(self, '\n'));
+static void _obj_skip(Parser *self) {
+  const char *s = self->src;
+  for (;;) {
+    while (_obj_class[(uint8_t)*s] & _OBJ_SPACE) s += 1;
+    if (*s != '#') break;
+    while (*s && *s != '\n') s += 1;
   }
-  return begin != self->src;
+  self->src = s;
 }
 
-static void _obj_skip(Parser *self) {
-  while (_obj_empty(self) || _obj_comment(self));
+/* exact powers of ten representable as doubles */
+static const double _obj_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Locale independent decimal scanner, handles sign, fraction and exponent.
+ * Keeps up to 19 significant digits in an integer and scales once at the end,
+ * which is plenty for single precision. Leaves src untouched on failure. */
+static bool _obj_number(Parser *self, double *out) {
+  const char *s = self->src;
+  bool neg = false;
+  if (*s == '-' || *s == '+') neg = *s++ == '-';
+
+  uint64_t mant = 0;
+  int exp = 0, digits = 0;
+  for (; _obj_isdigit(*s); s += 1, digits += 1) {
+    if (mant < 1000000000000000000ull) mant = mant*10 + (uint64_t)(*s-'0');
+    else exp += 1;
+  }
+  if (*s == '.') {
+    for (s += 1; _obj_isdigit(*s); s += 1, digits += 1)
+      if (mant < 1000000000000000000ull) {
+        mant = mant*10 + (uint64_t)(*s-'0');
+        exp -= 1;
+      }
+  }
+  if (digits == 0) return false;
+
+  if (*s == 'e' || *s == 'E') {
+    const char *e = s+1;
+    bool eneg = false;
+    if (*e == '-' || *e == '+') eneg = *e++ == '-';
+    if (_obj_isdigit(*e)) {
+      int ev = 0;
+      for (; _obj_isdigit(*e); e += 1)
+        if (ev < 10000) ev = ev*10 + (*e-'0');
+      exp += eneg ? -ev : ev;
+      s = e;
+    }
+  }
+
+  double scale = 1.0;
+  int a = exp < 0 ? -exp : exp;
+  for (; a > 22; a -= 22) scale *= 1e22;
+  scale *= _obj_pow10[a];
+  double r = exp < 0 ? (double)mant/scale : (double)mant*scale;
+  *out = neg ? -r : r;
+  self->src = s;
+  return true;
 }
 
+/* the is* checks only peek at the start of the token, they never parse it */
 static bool _obj_isfloat(Parser *self) {
   _obj_skip(self);
-  char *end = (char*)self->src;
-
-  // Todo(bumbread): don't waste time parsing the float,
-  // just forward scan for the '.' symbol, or use state-based
-  // automation.
-  strtod(self->src, &end);
-  
-  return end != self->src;
+  const char *s = self->src;
+  if (*s == '-' || *s == '+') s += 1;
+  if (*s == '.') s += 1;
+  return _obj_isdigit(*s);
 }
 
 static bool _obj_isint(Parser *self) {
   _obj_skip(self);
-  char *end = (char*)self->src;
-  strtol(self->src, &end, 10);
-  return end != self->src;
+  const char *s = self->src;
+  if (*s == '-' || *s == '+') s += 1;
+  return _obj_isdigit(*s);
 }
 
 static float _obj_float(Parser *self) {
   _obj_skip(self);
-  char *end = (char*)self->src;
-  float r = strtof(self->src, &end);
-  assert(end != self->src && "Obj: Supplied empty float");
-  self->src = end;
-  return r;
+  double r = 0.0;
+  bool ok = _obj_number(self, &r);
+  assert(ok && "Obj: Supplied empty float");
+  (void)ok;
+  return (float)r;
 }
 
-static uint16_t _obj_int(Parser *self) {
+static uint32_t _obj_int(Parser *self) {
   _obj_skip(self);
-  char *end = (char*)self->src;
-  long r = strtol(self->src, &end, 10);
-  assert(end != self->src && "Obj: Supplied empty int");
-  self->src = end;
-  return (uint16_t)r;
+  const char *s = self->src;
+  bool neg = false;
+  if (*s == '-' || *s == '+') neg = *s++ == '-';
+  assert(_obj_isdigit(*s) && "Obj: Supplied empty int");
+  long r = 0;
+  for (; _obj_isdigit(*s); s += 1)
+    r = r*10 + (*s-'0');
+  self->src = s;
+  return (uint32_t)(neg ? -r : r);
 }
 
 static obj_Triplet _obj_triplet(Parser *self) {
-  uint16_t v = 0, t = 0, n = 0;
+  uint32_t v = 0, t = 0, n = 0;
   v = _obj_int(self);
   if (chk(self, '/')) {
     next(self);
@@ -164,11 +222,94 @@ static void _obj_cmd_vertex(Parser *self, obj_Result *res, void via(obj_Result *
   assert(!_obj_isfloat(self) && "Obj: Passed too much parameters to vertex");
 }
 
+/* Splits a face into triangles by clipping ears off it, which also handles
+ * concave faces. The face is projected onto the plane its normal is most
+ * aligned with. Falls back to a fan if the corners reference positions that
+ * weren't parsed yet, or if the face is too degenerate to find an ear in. */
+static void _obj_triangulate(obj_Result *res, const obj_Triplet *corners, size_t n) {
+  size_t left[OBJ_MAX_CORNERS];
+  float x[OBJ_MAX_CORNERS], y[OBJ_MAX_CORNERS];
+  bool positioned = n > 3;
+  for (size_t i = 0; i < n; i += 1)
+    positioned = positioned && corners[i].v > 0 && corners[i].v*3 <= res->vertex_count;
+
+  if (positioned) {
+    /* Newell's method gives the normal of a non-planar or concave polygon */
+    float nrm[3] = { 0 };
+    for (size_t i = 0; i < n; i += 1) {
+      const float *a = res->vertices + (corners[i].v-1)*3;
+      const float *b = res->vertices + (corners[(i+1)%n].v-1)*3;
+      nrm[0] += (a[1]-b[1])*(a[2]+b[2]);
+      nrm[1] += (a[2]-b[2])*(a[0]+b[0]);
+      nrm[2] += (a[0]-b[0])*(a[1]+b[1]);
+    }
+    int axis = fabsf(nrm[0]) > fabsf(nrm[1]) ? (fabsf(nrm[0]) > fabsf(nrm[2]) ? 0 : 2)
+                                              : (fabsf(nrm[1]) > fabsf(nrm[2]) ? 1 : 2);
+    int u = (axis+1)%3, v = (axis+2)%3;
+    /* keep the projected winding counter clockwise */
+    float flip = nrm[axis] < 0.0f ? -1.0f : 1.0f;
+    for (size_t i = 0; i < n; i += 1) {
+      const float *p = res->vertices + (corners[i].v-1)*3;
+      x[i] = p[u];
+      y[i] = p[v]*flip;
+      left[i] = i;
+    }
+
+    size_t count = n;
+    while (count > 3) {
+      bool clipped = false;
+      for (size_t i = 0; i < count && !clipped; i += 1) {
+        size_t a = left[(i+count-1)%count], b = left[i], c = left[(i+1)%count];
+        float cross = (x[b]-x[a])*(y[c]-y[a]) - (y[b]-y[a])*(x[c]-x[a]);
+        if (cross <= 0.0f) continue;
+
+        /* an ear may not contain any of the remaining corners */
+        bool ear = true;
+        for (size_t j = 0; j < count && ear; j += 1) {
+          size_t p = left[j];
+          if (p == a || p == b || p == c) continue;
+          float d0 = (x[b]-x[a])*(y[p]-y[a]) - (y[b]-y[a])*(x[p]-x[a]);
+          float d1 = (x[c]-x[b])*(y[p]-y[b]) - (y[c]-y[b])*(x[p]-x[b]);
+          float d2 = (x[a]-x[c])*(y[p]-y[c]) - (y[a]-y[c])*(x[p]-x[c]);
+          ear = d0 < 0.0f || d1 < 0.0f || d2 < 0.0f;
+        }
+        if (!ear) continue;
+
+        _obj_index(res, corners[a]);
+        _obj_index(res, corners[b]);
+        _obj_index(res, corners[c]);
+        memmove(left+i, left+i+1, (count-i-1)*sizeof(size_t));
+        count -= 1;
+        clipped = true;
+      }
+      if (!clipped) break;
+    }
+
+    /* whatever is left is either a triangle or hopelessly degenerate */
+    for (size_t i = 1; i+1 < count; i += 1) {
+      _obj_index(res, corners[left[0]]);
+      _obj_index(res, corners[left[i]]);
+      _obj_index(res, corners[left[i+1]]);
+    }
+    return;
+  }
+
+  for (size_t i = 1; i+1 < n; i += 1) {
+    _obj_index(res, corners[0]);
+    _obj_index(res, corners[i]);
+    _obj_index(res, corners[i+1]);
+  }
+}
+
 static void _obj_cmd_index(Parser *self, obj_Result *res) {
-  _obj_index(res, _obj_triplet(self));
-  _obj_index(res, _obj_triplet(self));
-  _obj_index(res, _obj_triplet(self));
-  assert(!_obj_isint(self) && "Obj: More than 3 indices unsupported, export with \"Triangulate faces\" flag in blender");
+  obj_Triplet corners[OBJ_MAX_CORNERS];
+  size_t n = 0;
+  while (_obj_isint(self)) {
+    assert(n < OBJ_MAX_CORNERS && "Obj: Face has too many corners");
+    corners[n++] = _obj_triplet(self);
+  }
+  assert(n >= 3 && "Obj: Face needs at least 3 corners");
+  _obj_triangulate(res, corners, n);
 }
 
 __attribute__((unused))
@@ -200,21 +341,54 @@ static void obj_dump(obj_Result *self) {
 }
 
 static void _obj_ignore(Parser *self, const char *cmd) {
+#ifndef OBJ_QUIET
   printf("Obj: %s command, ignoring\n", cmd);
+#else
+  (void)cmd;
+#endif
   while (*self->src && !chk(self, '\n')) {
     next(self);
   }
 }
 
+/* Counts the floats and face corners in `src` so that obj_parse can
+ * allocate exactly once. Lines are told apart by their first letters just as
+ * obj_parse's prefix checks do, whatever follows the keyword. Faces with n
+ * corners need room for n-2 triangles. */
+static void _obj_count(const char *src, obj_Result *res) {
+  while (*src) {
+    while (_obj_class[(uint8_t)*src] & _OBJ_SPACE) src += 1;
+    if (src[0] == 'v') {
+      if (src[1] == 't') res->_uv_cap += 2;
+      else if (src[1] == 'n') res->_normal_cap += 3;
+      else if (src[1] != 'p') res->_vertex_cap += 3;
+    } else if (src[0] == 'f') {
+      size_t corners = 0;
+      bool gap = true;
+      for (const char *c = src+1; *c && *c != '\n' && *c != '#'; c += 1) {
+        bool space = _obj_class[(uint8_t)*c] & _OBJ_SPACE;
+        if (gap && !space) corners += 1;
+        gap = space;
+      }
+      if (corners >= 3)
+        res->_index_cap += (corners-2)*3;
+    }
+    const char *end = strchr(src, '\n');
+    src = end ? end+1 : src + strlen(src);
+  }
+}
+
 __attribute__((unused))
 static obj_Result obj_parse(const char *src) {
   Parser self = { .src = src };
-  obj_Result res = {
-    .indices = (obj_Triplet*)malloc(INDEX_COUNT*sizeof(obj_Triplet)),
-    .vertices = (float*)malloc(VERTEX_COUNT*sizeof(float)),
-    .normals = (float*)malloc(VERTEX_COUNT*sizeof(float)),
-    .uvs = (float*)malloc(VERTEX_COUNT*sizeof(float)),
-  };
+  obj_Result res = { 0 };
+  _obj_count(src, &res);
+  res._block = malloc(res._index_cap*sizeof(obj_Triplet) +
+                      (res._vertex_cap + res._uv_cap + res._normal_cap)*sizeof(float));
+  res.indices = (obj_Triplet*)res._block;
+  res.vertices = (float*)(res.indices + res._index_cap);
+  res.uvs = res.vertices + res._vertex_cap;
+  res.normals = res.uvs + res._uv_cap;
 
   while (*self.src) {
     _obj_skip(&self);
@@ -244,101 +418,79 @@ static obj_Result obj_parse(const char *src) {
 
 __attribute__((unused))
 static void obj_dispose(obj_Result *res) {
-  free(res->indices);
-  free(res->uvs);
-  free(res->normals);
-  free(res->vertices);
+  free(res->_block);
+  *res = (obj_Result) { 0 };
 }
 
 static inline bool _obj_triplet_eq(obj_Triplet a, obj_Triplet b) {
   return a.v == b.v && a.vn == b.vn && a.vt == b.vt;
 }
 
-typedef struct {
-  obj_Triplet chk;
-  size_t index;
-} _obj_MemoNode;
-
-static _obj_MemoNode _obj_memo[1 << 12] = { 0 };
-static inline size_t _obj_memo_insert(obj_Triplet triplet, size_t index) {
-  size_t hash = (triplet.v+triplet.vn*32+triplet.vt*128*(1<<12))&((1 << 12)-1);
-  if (_obj_memo[hash].index == 0) {
-    _obj_memo[hash] = (_obj_MemoNode) { triplet, index+1 };
-  }
-  return index;
+static inline size_t _obj_triplet_hash(obj_Triplet t) {
+  uint32_t h = (uint32_t)t.v*0x9e3779b1u ^ (uint32_t)t.vt*0x85ebca77u ^ (uint32_t)t.vn*0xc2b2ae3du;
+  return h ^ (h >> 15);
 }
 
-static inline size_t _obj_memo_get(obj_Triplet triplet) {
-  size_t hash = (triplet.v+triplet.vn*32+triplet.vt*128*(1<<12))&((1 << 12)-1);
-  if (_obj_memo[hash].index != 0 && _obj_triplet_eq(_obj_memo[hash].chk, triplet))
-    return _obj_memo[hash].index;
-  return 0;
-}
-
-// This function sucks
-__attribute__((unused))
-static size_t _obj_triplet_pos(obj_Result *res, obj_Triplet triplet, size_t nd) {
-  size_t index = 0;
-  if ((index = _obj_memo_get(triplet))) {
-    return index-1;
-  }
-  for (size_t i = 0; i < nd; i += 1) {
-    for (size_t j = 0; j < i; j += 1)
-      if (_obj_triplet_eq(res->indices[i], res->indices[j])) {
-        index -= 1;
-        break;
-      }
-    if (_obj_triplet_eq(res->indices[i], triplet))
-      return _obj_memo_insert(triplet, index);
-    index += 1;
-  }
-
-  assert(false && "Triplet not found");
-}
+/* open addressing table from triplet to unrolled vertex, index 0 marks an empty slot */
+typedef struct {
+  obj_Triplet key;
+  uint32_t index;
+} _obj_DedupSlot;
 
 // Unrolls as (POSITION3, UV2, NORMAL3)
 __attribute__((unused))
 static obj_Unrolled obj_unroll_pun(obj_Result *res, size_t *vertex_count) {
-#ifdef NDEBUG
-  memset(_obj_memo, 0, sizeof(_obj_memo));
-#endif
   obj_Unrolled unrolled = {
-    .indices  = (uint16_t*)malloc(res->index_count*sizeof(uint16_t)),
-    .vertices = (float*)malloc(res->index_count*sizeof(float)*8), // POSITION 3 + UV 2 + NORMAL 3 
+    .indices  = (uint32_t*)malloc(res->index_count*sizeof(uint32_t)),
   };
-  size_t maxpos = 0;
+  /* at most half full, so probes stay short */
+  size_t cap = 16;
+  while (cap < res->index_count*2) cap *= 2;
+  _obj_DedupSlot *slots = (_obj_DedupSlot*)calloc(cap, sizeof(_obj_DedupSlot));
+
+  /* number the distinct triplets in the order they first appear */
+  size_t unique = 0;
   for (size_t i = 0; i < res->index_count; i += 1) {
     obj_Triplet trp = res->indices[i];
     assert(trp.v != 0 && trp.vn != 0 && trp.vt != 0 && "Obj: Cannot consturct PUN format without according vertices present (malformed index)");
-    assert(trp.v <= res->vertex_count && trp.vn <= res->normal_count && trp.vt <= res->uv_count && "Obj: Cannot consturct PUN format with index pointing to a vertex out of bounds (malformed index)");
+    assert(trp.v*3u <= res->vertex_count && trp.vn*3u <= res->normal_count && trp.vt*2u <= res->uv_count && "Obj: Cannot consturct PUN format with index pointing to a vertex out of bounds (malformed index)");
 
-#ifdef NDEBUG
-    const size_t triplet_pos = _obj_triplet_pos(res, trp, i+1);
-#else
-    const size_t triplet_pos = i;
-#endif
+    size_t slot = _obj_triplet_hash(trp) & (cap-1);
+    while (slots[slot].index != 0 && !_obj_triplet_eq(slots[slot].key, trp))
+      slot = (slot+1) & (cap-1);
+    if (slots[slot].index == 0) {
+      slots[slot] = (_obj_DedupSlot) { trp, (uint32_t)++unique };
+    }
+    unrolled.indices[i] = slots[slot].index-1;
+  }
+  free(slots);
 
-    maxpos = triplet_pos > maxpos ? triplet_pos : maxpos;
+  /* now that the count is known, write each vertex where its number first shows up */
+  unrolled.vertices = (float*)malloc(unique*sizeof(float)*8); // POSITION 3 + UV 2 + NORMAL 3 
+  size_t written = 0;
+  for (size_t i = 0; i < res->index_count && written < unique; i += 1) {
+    if (unrolled.indices[i] != written) continue;
+    obj_Triplet trp = res->indices[i];
+    float *dst = unrolled.vertices + written*8;
     trp.v -= 1;  // (1 indexed fix)
     trp.vn -= 1; // (1 indexed fix)
     trp.vt -= 1; // (1 indexed fix)
-    // Might have some redundant writes but it doesn't matter cuz triplet pos function already sucks
-    unrolled.vertices[triplet_pos*8+0] = res->vertices[trp.v*3+0];
-    unrolled.vertices[triplet_pos*8+1] = res->vertices[trp.v*3+1];
-    unrolled.vertices[triplet_pos*8+2] = res->vertices[trp.v*3+2];
+    dst[0] = res->vertices[trp.v*3+0];
+    dst[1] = res->vertices[trp.v*3+1];
+    dst[2] = res->vertices[trp.v*3+2];
     // Uv
-    unrolled.vertices[triplet_pos*8+3] = res->uvs[trp.vt*2+0];
-    unrolled.vertices[triplet_pos*8+4] = res->uvs[trp.vt*2+1];
+    dst[3] = res->uvs[trp.vt*2+0];
+    dst[4] = res->uvs[trp.vt*2+1];
     // Normals
-    unrolled.vertices[triplet_pos*8+5] = res->normals[trp.vn*3+0];
-    unrolled.vertices[triplet_pos*8+6] = res->normals[trp.vn*3+1];
-    unrolled.vertices[triplet_pos*8+7] = res->normals[trp.vn*3+2];
-
-    unrolled.indices[i] = (uint16_t)triplet_pos;
+    dst[5] = res->normals[trp.vn*3+0];
+    dst[6] = res->normals[trp.vn*3+1];
+    dst[7] = res->normals[trp.vn*3+2];
+    written += 1;
   }
+
   if (vertex_count != NULL)
-    *vertex_count = maxpos+1;
-  printf("Vertex count is %zu\n", *vertex_count);
+    *vertex_count = unique;
+  printf("Vertex count is %zu\n", unique);
   return unrolled;
 }
 
@@ -349,8 +501,5 @@ static void obj_dispose_unrolled(obj_Unrolled *unrolled) {
 
 #undef Parser
 #undef chk
-#undef oneof
 #undef next
 #undef verify
-#undef VERTEX_COUNT
-#undef INDEX_COUNT
@@ -3,12 +3,6 @@ typedef struct {
   size_t index_count;
 } _ol_Shape;
 
-static struct {
-  _ol_Shape quad_shape;
-  sg_pipeline pip;
-  sg_bindings bind;
-} _ol_state;
-
 typedef struct {
   int x;
   int y;
@@ -16,24 +10,101 @@ typedef struct {
   int h;
 } ol_Rect;
 
+static struct {
+  _ol_Shape quad_shape;
+  sg_pipeline pip;
+  sg_bindings bind;
+  /* the ASSET_ATLAS images, see ol_load_image */
+  sg_image atlas;
+  int atlas_width, atlas_height;
+  ol_Rect atlas_rects[ASSET_ATLAS_RECTS];
+} _ol_state;
+
 typedef struct {
   ol_Rect outer;
   ol_Rect inner;
 } ol_NinePatch;
 
+/* `width` by `height` texels at `x`, `y` of `sg`, which is only bigger
+ * than that for the images in the atlas */
 typedef struct {
   sg_image sg;
   int width, height;
+  int x, y;
+  int sg_width, sg_height;
 } ol_Image;
 
+/* The distance field glyphs of a font, see asset_pack_font */
 typedef struct {
-  stbtt_packedchar pc[256];
-  int size;
-  int ascent;
-  float scale;
+  stbtt_packedchar pc[ASSET_FONT_CHARS];
+  /* in pixels at sdf_size */
+  int sdf_size;
+  float ascent;
+  float spread;
   ol_Image img;
+} ol_FontFace;
+
+/* A face drawn `size` pixels high */
+typedef struct {
+  const ol_FontFace *face;
+  int size;
 } ol_Font;
 
+/* Uploads the atlas, replacing the one in _ol_state.atlas when `reload`.
+ * A new atlas that can't be packed leaves the old one as it is. */
+static bool _ol_load_atlas(bool reload) {
+  asset_Atlas baked;
+  asset_AtlasHeader header;
+  const asset_Rect *rects;
+  const uint8_t *pixels;
+  uint8_t *packed = NULL;
+
+  if (asset_open_atlas(&baked)) {
+    header = *baked.header;
+    rects = baked.rects;
+    pixels = baked.pixels;
+  } else {
+    size_t size;
+    packed = asset_pack_atlas(&header, &size);
+    if (packed == NULL) return false;
+    rects = (const asset_Rect*)packed;
+    pixels = (const uint8_t*)(rects + ASSET_ATLAS_RECTS);
+  }
+
+  /* the handle stays the same, images already looked up keep drawing */
+  if (reload)
+    sg_uninit_image(_ol_state.atlas);
+  sg_init_image(_ol_state.atlas, &(sg_image_desc) {
+    .width = (int)header.width,
+    .height = (int)header.height,
+    .min_filter = SG_FILTER_NEAREST,
+    .mag_filter = SG_FILTER_NEAREST,
+    .data.subimage[0][0] = (sg_range){ pixels, (size_t)header.width*header.height*4 },
+  });
+  _ol_state.atlas_width = (int)header.width;
+  _ol_state.atlas_height = (int)header.height;
+  for (int i = 0; i < ASSET_ATLAS_RECTS; i++)
+    _ol_state.atlas_rects[i] = (ol_Rect) { rects[i].x, rects[i].y, rects[i].w, rects[i].h };
+
+  if (baked.header != NULL)
+    asset_close_atlas(&baked);
+  free(packed);
+  return true;
+}
+
+static ol_Image _ol_atlas_image(int index) {
+  ol_Rect r = _ol_state.atlas_rects[index];
+  return (ol_Image) {
+    .sg = _ol_state.atlas,
+    .width = r.w,
+    .height = r.h,
+    .x = r.x,
+    .y = r.y,
+    .sg_width = _ol_state.atlas_width,
+    .sg_height = _ol_state.atlas_height,
+  };
+}
+
 void ol_init() {
   const float vertices[] = {
     0, 1,   0, 1,
@@ -78,17 +149,50 @@ void ol_init() {
       .dst_factor_alpha = SG_BLENDFACTOR_ZERO
     }
   });
+
+  _ol_state.atlas = sg_alloc_image();
+  bool ok = _ol_load_atlas(false);
+  assert(ok && "Failed to pack the overlay atlas");
+  (void)ok;
+}
+
+/* Packs the atlas again after one of its images changed. Images looked up
+ * before keep drawing, but their part of it may have moved, look them up again. */
+void ol_reload_atlas() {
+  if (!_ol_load_atlas(true))
+    fprintf(stderr, "Could not pack the overlay atlas, keeping the old one\n");
 }
 
 ol_Image ol_image_from_sg(sg_image sg, int w, int h) {
   return (ol_Image) {
     .width = w,
     .height = h,
-    .sg = sg
+    .sg = sg,
+    .sg_width = w,
+    .sg_height = h,
   };
 }
 
+/* Images packed into the atlas are looked up there, anything else gets an image of its own */
 ol_Image ol_load_image(const char *path) {
+  int index = asset_atlas_find(path);
+  if (index >= 0)
+    return _ol_atlas_image(index);
+
+  asset_Texture baked;
+  if (asset_open_texture(path, false, 1u << bcn_Format_RGBA8, &baked)) {
+    int w = (int)baked.header->width, h = (int)baked.header->height;
+    sg_image img = sg_make_image(&(sg_image_desc){
+      .width = w,
+      .height = h,
+      .min_filter = SG_FILTER_NEAREST,
+      .mag_filter = SG_FILTER_NEAREST,
+      .data.subimage[0][0] = (sg_range){ baked.levels[0], (size_t)w*(size_t)h*4 },
+    });
+    asset_close_texture(&baked);
+    return ol_image_from_sg(img, w, h);
+  }
+
   cp_image_t png = cp_load_png(path);
  // cp_flip_image_horizontal(&png);
   size_t w = (size_t)png.w, h = (size_t)png.h;
@@ -99,64 +203,87 @@ ol_Image ol_load_image(const char *path) {
     .mag_filter = SG_FILTER_NEAREST,
     .data.subimage[0][0] = (sg_range){ png.pix,w*h*sizeof(cp_pixel_t) } ,
   });
-  ol_Image res = {
-    .width = png.w,
-    .height = png.h,
-    .sg = img
-  };
+  ol_Image res = ol_image_from_sg(img, png.w, png.h);
   cp_free_png(&png);
   return res;
 }
 
-#define ATLAS_SIZE 1024
-
-ol_Font ol_load_font(const char *path) {
-  static uint8_t ttf_buffer[1 << 25];
-  static uint8_t atlas[1024*1024];
-  FILE *f = fopen(path, "rb");
-  fread(ttf_buffer, 1, 1 << 25, f);
-
-  ol_Font font;
-  stbtt_fontinfo info;
-  int ascent;
-  float scale;
-  font.size = 32;
-
-  stbtt_InitFont(&info, ttf_buffer, 0);
-  scale = stbtt_ScaleForPixelHeight(&info, (float)font.size);
-  stbtt_GetFontVMetrics(&info, &ascent, NULL, NULL); 
-
-  font.ascent = ascent;
-  font.scale = scale;
-
-  stbtt_pack_context context;
-  assert(stbtt_PackBegin(&context, atlas, ATLAS_SIZE, ATLAS_SIZE, ATLAS_SIZE, 1, NULL) && "Failed to load font");
-  stbtt_PackSetOversampling(&context, 2, 2);
-  assert(stbtt_PackFontRange(&context, ttf_buffer, 0, (float)font.size, 0, 256, font.pc) && "Failed font packing");
-  font.img = ol_image_from_sg(sg_make_image(&(sg_image_desc) {
-    .pixel_format = SG_PIXELFORMAT_R8,
-    .width = ATLAS_SIZE,
-    .height = ATLAS_SIZE,
-    .data.subimage[0][0] = (sg_range){atlas, ATLAS_SIZE*ATLAS_SIZE*sizeof(uint8_t)}
-  }), ATLAS_SIZE, ATLAS_SIZE);
-  return font;
+#define ATLAS_SIZE ASSET_FONT_ATLAS_SIZE
+
+/* Loads the glyphs of `path` into `face`. Without a baked font the file is
+ * mapped and its glyphs rendered here, the atlas is only kept until it's uploaded. */
+void ol_load_font_face(const char *path, ol_FontFace *face) {
+  asset_Font baked;
+  asset_FontHeader header;
+  const stbtt_packedchar *chars;
+  const uint8_t *atlas_pixels;
+  uint8_t *packed = NULL;
+
+  if (asset_open_font(path, &baked)) {
+    header = *baked.header;
+    chars = baked.chars;
+    atlas_pixels = baked.atlas;
+  } else {
+    fio_Map ttf;
+    bool mapped = fio_map(path, &ttf);
+    assert(mapped && "Failed to read font");
+    (void)mapped;
+    packed = malloc(ASSET_FONT_DATA_SIZE);
+    bool ok = asset_pack_font((const uint8_t*)ttf.data, &header, packed);
+    assert(ok && "Failed font packing");
+    (void)ok;
+    fio_unmap(&ttf);
+    chars = (const stbtt_packedchar*)packed;
+    atlas_pixels = (const uint8_t*)(chars + ASSET_FONT_CHARS);
+  }
+
+  *face = (ol_FontFace) {
+    .sdf_size = header.sdf_size,
+    .ascent = header.ascent,
+    .spread = header.spread,
+    /* filtered, the field is scaled both up and down */
+    .img = ol_image_from_sg(sg_make_image(&(sg_image_desc) {
+      .pixel_format = SG_PIXELFORMAT_R8,
+      .width = ATLAS_SIZE,
+      .height = ATLAS_SIZE,
+      .min_filter = SG_FILTER_LINEAR,
+      .mag_filter = SG_FILTER_LINEAR,
+      .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+      .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+      .data.subimage[0][0] = (sg_range){atlas_pixels, ATLAS_SIZE*ATLAS_SIZE*sizeof(uint8_t)}
+    }), ATLAS_SIZE, ATLAS_SIZE),
+  };
+  memcpy(face->pc, chars, sizeof(face->pc));
+  if (baked.header != NULL)
+    asset_close_font(&baked);
+  free(packed);
+}
+
+ol_Font ol_font(const ol_FontFace *face, int size) {
+  return (ol_Font) { .face = face, .size = size };
 }
 
 void ol_begin() {
   sg_apply_pipeline(_ol_state.pip);
+  /* the pipeline drops the bindings, the next quad applies them */
+  _ol_state.bind.fs_images[SLOT_tex] = (sg_image) { SG_INVALID_ID };
 }
 
-void _ol_draw_tex_part(ol_Image *img, ol_Rect r, ol_Rect part, Vec4 modulate, bool istxt) {
-  _ol_state.bind.index_buffer = _ol_state.quad_shape.ibuf;
-  _ol_state.bind.vertex_buffers[0] = _ol_state.quad_shape.vbuf;
-  _ol_state.bind.fs_images[SLOT_tex] = img->sg;
-  sg_apply_bindings(&_ol_state.bind); 
+/* `softness` above 0 draws `img` as a distance field, blending its edge over that much of the field */
+void _ol_draw_quad(const ol_Image *img, Vec2 pos, Vec2 size, Vec2 minuv, Vec2 sizuv, Vec4 modulate, float softness) {
+  /* only the image changes between quads, and not at all while drawing from the atlas */
+  if (_ol_state.bind.fs_images[SLOT_tex].id != img->sg.id) {
+    _ol_state.bind.index_buffer = _ol_state.quad_shape.ibuf;
+    _ol_state.bind.vertex_buffers[0] = _ol_state.quad_shape.vbuf;
+    _ol_state.bind.fs_images[SLOT_tex] = img->sg;
+    sg_apply_bindings(&_ol_state.bind);
+  }
   overlay_vs_params_t overlay_vs_params = { 
-    .istxt = istxt ? 1.0 : 0.0,
-    .minuv = vec2((float)part.x/(float)img->width, (float)part.y/(float)img->height),
-    .sizuv = vec2((float)part.w/(float)img->width, (float)part.h/(float)img->height),
-    .pos = vec2(r.x, r.y),
-    .size = vec2(r.w, r.h),
+    .softness = softness,
+    .minuv = minuv,
+    .sizuv = sizuv,
+    .pos = pos,
+    .size = size,
     .resolution = vec2(sapp_widthf(), sapp_heightf()),
     .modulate = modulate,
   };
@@ -164,6 +291,13 @@ void _ol_draw_tex_part(ol_Image *img, ol_Rect r, ol_Rect part, Vec4 modulate, bo
   sg_draw(0, (int)_ol_state.quad_shape.index_count, 1);
 }
 
+void _ol_draw_tex_part(ol_Image *img, ol_Rect r, ol_Rect part, Vec4 modulate) {
+  _ol_draw_quad(img, vec2(r.x, r.y), vec2(r.w, r.h),
+                vec2((float)(img->x + part.x)/(float)img->sg_width, (float)(img->y + part.y)/(float)img->sg_height),
+                vec2((float)part.w/(float)img->sg_width, (float)part.h/(float)img->sg_height),
+                modulate, 0.0f);
+}
+
 void ol_ninepatch(ol_Image *img, ol_Rect r, ol_NinePatch np, Vec4 modulate) {
   const int SRC[2][3] = { 
     /* X */ { np.inner.x, np.inner.w, np.outer.w-(np.inner.x+np.inner.w) },
@@ -179,7 +313,7 @@ void ol_ninepatch(ol_Image *img, ol_Rect r, ol_NinePatch np, Vec4 modulate) {
     int sy = np.outer.y;
     int dy = r.y;
     for (int j = 0; j < 3; j += 1) {
-      _ol_draw_tex_part(img, (ol_Rect) { dx, dy, DST[0][i], DST[1][j] }, (ol_Rect) { sx, sy, SRC[0][i], SRC[1][j] }, modulate, false);
+      _ol_draw_tex_part(img, (ol_Rect) { dx, dy, DST[0][i], DST[1][j] }, (ol_Rect) { sx, sy, SRC[0][i], SRC[1][j] }, modulate);
       sy += SRC[1][j];
       dy += DST[1][j];
     }
@@ -189,56 +323,58 @@ void ol_ninepatch(ol_Image *img, ol_Rect r, ol_NinePatch np, Vec4 modulate) {
 }
 
 void ol_draw_tex_part_ex(ol_Image *img, ol_Rect r, ol_Rect part, Vec4 modulate) {
-  _ol_draw_tex_part(img, r, part, modulate, false);
+  _ol_draw_tex_part(img, r, part, modulate);
 }
 
 void ol_draw_tex_part(ol_Image *img, ol_Rect r, ol_Rect part) {
-  _ol_draw_tex_part(img, r, part, vec4(1.0, 1.0, 1.0, 1.0), false);
+  _ol_draw_tex_part(img, r, part, vec4(1.0, 1.0, 1.0, 1.0));
 }
 
+/* Where a glyph goes with the pen at `x` and the top of the line at `y`,
+ * and how far it moves the pen */
 typedef struct {
-  ol_Rect dest;
-  ol_Rect part;
-  int stride;
+  Vec2 pos, size;
+  Vec2 minuv, sizuv;
+  float advance;
 } ol_Glyph;
 
-ol_Glyph ol_glyph_info(ol_Font *font, int glyph, int x, int y) {
-  float startx = (float )x;
-  float px = (float) x, py = (float) y;
-  stbtt_aligned_quad quad;
-  stbtt_GetPackedQuad(font->pc, ATLAS_SIZE, ATLAS_SIZE, glyph, &px, &py, &quad, 1);
+ol_Glyph ol_glyph_info(ol_Font *font, int glyph, float x, float y) {
+  const ol_FontFace *face = font->face;
+  const stbtt_packedchar *pc = face->pc + glyph%ASSET_FONT_CHARS;
+  float k = (float)font->size/(float)face->sdf_size;
+  float baseline = y + face->ascent*k;
   return (ol_Glyph) {
-    .dest = { (int)quad.x0, (int)(quad.y0+((float)font->ascent*font->scale)), (int)quad.x1-(int)quad.x0, (int)quad.y1-(int)quad.y0 },
-    .part = { 
-      (int)(quad.s0*(float)font->img.width),
-      (int)(quad.t0*(float)font->img.height),
-      (int)((quad.s1-quad.s0)*(float)font->img.width),
-      (int)((quad.t1-quad.t0)*(float)font->img.height) 
-    },
-    .stride =  (int)(px-startx)
+    .pos = vec2(x + pc->xoff*k, baseline + pc->yoff*k),
+    .size = vec2((pc->xoff2 - pc->xoff)*k, (pc->yoff2 - pc->yoff)*k),
+    .minuv = vec2((float)pc->x0/ATLAS_SIZE, (float)pc->y0/ATLAS_SIZE),
+    .sizuv = vec2((float)(pc->x1 - pc->x0)/ATLAS_SIZE, (float)(pc->y1 - pc->y0)/ATLAS_SIZE),
+    .advance = pc->xadvance*k,
   };
 }
 
-int ol_draw_glyph(ol_Font *font, int glyph, int x, int y, Vec4 modulate) {
-  ol_Glyph glyph_value = ol_glyph_info(font, glyph, x, y);
-  _ol_draw_tex_part(&font->img, glyph_value.dest, glyph_value.part, modulate, true);
-  return glyph_value.stride;
+float ol_draw_glyph(ol_Font *font, int glyph, float x, float y, Vec4 modulate) {
+  ol_Glyph g = ol_glyph_info(font, glyph, x, y);
+  /* about one screen pixel of the field, whatever the field is scaled to */
+  float softness = 0.5f*font->face->spread*(float)font->face->sdf_size/(float)font->size;
+  if (g.size.x > 0.0f)
+    _ol_draw_quad(&font->face->img, g.pos, g.size, g.minuv, g.sizuv, modulate, softness);
+  return g.advance;
 }
 
 ol_Rect ol_measure_text(ol_Font *font, const char *text, int x, int y) {
-  int stride = 0;
+  float stride = 0.0f;
   for (;*text; text += 1) {
-    stride += ol_glyph_info(font, *text, x+stride, y).stride;
+    stride += ol_glyph_info(font, (uint8_t)*text, (float)x + stride, (float)y).advance;
   }
-  return (ol_Rect) { x, y, stride, font->size };
+  return (ol_Rect) { x, y, (int)ceilf(stride), font->size };
 }
 
 int ol_draw_text(ol_Font *font, const char *text, int x, int y, Vec4 modulate) {
-  int stride = 0;
+  float stride = 0.0f;
   for (;*text; text += 1) {
-    stride += ol_draw_glyph(font, *text, x+stride, y, modulate);
+    stride += ol_draw_glyph(font, (uint8_t)*text, (float)x + stride, (float)y, modulate);
   }
-  return stride;
+  return (int)ceilf(stride);
 }
 
 #undef ATLAS_SIZE
@@ -246,16 +382,10 @@ void ol_draw_tex(ol_Image *img, ol_Rect r) {
   ol_draw_tex_part(img, r, (ol_Rect) { 0, 0, img->width, img->height });
 }
 
+/* the atlas' white texel, tinted */
 void ol_draw_rect(Vec4 color, ol_Rect rect) {
-  const uint8_t pixel[4] = { (uint8_t)(color.x*255), (uint8_t)(color.y*255), (uint8_t)(color.z*255), (uint8_t)(color.w*255) }; 
-  sg_image pixel_img = sg_make_image(&(sg_image_desc){ 
-    .width = 1,
-    .height = 1,
-    .data.subimage[0][0] = SG_RANGE(pixel)
-  });
-  ol_Image img = ol_image_from_sg(pixel_img, 1, 1);
-  ol_draw_tex(&img, rect);
-  sg_destroy_image(pixel_img);
+  ol_Image white = _ol_atlas_image(ASSET_ATLAS_WHITE);
+  _ol_draw_tex_part(&white, rect, (ol_Rect) { 0, 0, 1, 1 }, color);
 }
 
 
@@ -2,25 +2,51 @@
 @ctype vec4 Vec4
 @ctype vec2 Vec2
 
-@vs vs
+// mesh vertices are quantized, see mcache_Vertex
+@block mesh_vertex
 uniform vs_params {
   mat4 view_proj;
   mat4 model;
+  vec4 position_min;
+  vec4 position_extent;
+  // xy is the smallest uv, zw the extent
+  vec4 uv_range;
 };
 
-in vec3 position;
+in vec4 position;
 in vec2 uv;
-in vec3 normal;
+
+vec3 mesh_position() {
+  return position_min.xyz + position.xyz * position_extent.xyz;
+}
+
+vec2 mesh_uv() {
+  return uv_range.xy + uv * uv_range.zw;
+}
+@end
+
+@vs vs
+@include_block mesh_vertex
+
+in vec2 normal;
 
 out vec3 light;
 out vec2 fs_uv;
 
+// unfolds the octahedron the normal was projected onto
+vec3 mesh_normal() {
+  vec3 n = vec3(normal, 1.0 - abs(normal.x) - abs(normal.y));
+  float t = max(-n.z, 0.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
+
 void main() {
-  gl_Position = view_proj * model * vec4(position, 1.0);
-  fs_uv = uv;
+  gl_Position = view_proj * model * vec4(mesh_position(), 1.0);
+  fs_uv = mesh_uv();
 
   // vec3 frag_pos = vec3(model * vec4(position, 1));
-  vec3 fs_normal = mat3(transpose(inverse(model))) * normal;
+  vec3 fs_normal = mat3(transpose(inverse(model))) * mesh_normal();
 
   vec3 light_dir = -normalize(vec3(0.1, -1.0, 0.3));
   vec3 light_color = vec3(1.0);
@@ -73,19 +99,13 @@ void main() {
 // ---------------------------------------------------- //
 
 @vs laser_vs
-uniform vs_params {
-    mat4 view_proj;
-    mat4 model;
-};
-
-in vec3 position;
-in vec2 uv;
+@include_block mesh_vertex
 
 out vec2 fs_uv;
 
 void main() {
-  gl_Position = view_proj * model * vec4(position, 1.0);
-  fs_uv = uv;
+  gl_Position = view_proj * model * vec4(mesh_position(), 1.0);
+  fs_uv = mesh_uv();
 }
 @end
 
@@ -115,19 +135,13 @@ void main() {
 // ---------------------------------------------------- //
 
 @vs force_field_vs
-uniform vs_params {
-  mat4 view_proj;
-  mat4 model;
-};
-
-in vec3 position;
-in vec2 uv;
+@include_block mesh_vertex
 
 out vec2 fs_uv;
 
 void main() {
-  gl_Position = view_proj * model * vec4(position, 1.0);
-  fs_uv = uv;
+  gl_Position = view_proj * model * vec4(mesh_position(), 1.0);
+  fs_uv = mesh_uv();
 }
 @end
 
@@ -305,7 +319,7 @@ void main() {
 
 @vs overlay_vs
 uniform overlay_vs_params {
-  float istxt;
+  float softness;
   vec2 minuv;
   vec2 sizuv;
   vec2 pos;
@@ -318,10 +332,10 @@ in vec2 vert_pos;
 in vec2 uv;
 out vec2 fs_uv;
 out vec4 fs_modulate;
-out float fs_istxt;
+out float fs_softness;
 
 void main() {
-  fs_istxt = istxt;
+  fs_softness = softness;
   fs_modulate = modulate;
   fs_uv = minuv + uv * sizuv;
   vec2 screen_pos = pos + vert_pos * size;
@@ -337,12 +351,14 @@ layout (location = 0) out vec4 frag_color;
 layout (location = 1) out vec4 bright_color;
 in vec2 fs_uv;
 in vec4 fs_modulate;
-in float fs_istxt;
+in float fs_softness;
 
 void main() {
   vec4 color = texture(tex, fs_uv);
-  if (fs_istxt > 0.5) {
-    color = vec4(color.r, color.r, color.r, color.r);
+  /* text is a distance field with its outline at 0.5, see asset_pack_font */
+  if (fs_softness > 0.0) {
+    float coverage = smoothstep(0.5 - fs_softness, 0.5 + fs_softness, color.r);
+    color = vec4(coverage, coverage, coverage, coverage);
   }
   frag_color = color*fs_modulate;
 
@@ -367,10 +383,7 @@ void main() {
 
 @fs fsq_fs
 uniform sampler2D tex;
-uniform sampler2D blur0;
-uniform sampler2D blur1;
-uniform sampler2D blur2;
-uniform sampler2D blur3;
+uniform sampler2D bloom;
 
 in vec2 uv;
 
@@ -378,46 +391,81 @@ out vec4 frag_color;
 
 void main() {
   vec3 t = texture(  tex, uv).rgb +
-           texture(blur0, uv).rgb +
-           texture(blur1, uv).rgb +
-           texture(blur2, uv).rgb +
-           texture(blur3, uv).rgb ;
+           texture(bloom, uv).rgb ;
   frag_color = vec4(t, 1);
 }
 @end
 @program fsq fsq_vs fsq_fs
 
-@vs blur_vs
-@glsl_options flip_vert_y
+/* Dual-filter bloom: each downsample halves the resolution, reading a 4x4
+ * texel footprint of the source with 5 bilinear taps. The upsample reads the
+ * smaller level with a 3x3 tent of 8 bilinear taps and is additively blended
+ * onto the next larger level. */
+@fs bloom_down_fs
+uniform sampler2D tex;
 
-in vec2 pos;
+in vec2 uv;
 
-out vec2 uv;
+out vec4 frag_color;
 
 void main() {
-    gl_Position = vec4(pos*2.0-1.0, 0.5, 1.0);
-    uv = pos;
+  vec2 o = 1.0 / vec2(textureSize(tex, 0));
+  vec3 sum = texture(tex, uv).rgb * 4.0;
+  sum += texture(tex, uv - o).rgb;
+  sum += texture(tex, uv + o).rgb;
+  sum += texture(tex, uv + vec2(o.x, -o.y)).rgb;
+  sum += texture(tex, uv - vec2(o.x, -o.y)).rgb;
+  frag_color = vec4(sum / 8.0, 1.0);
 }
 @end
+@program bloom_down fsq_vs bloom_down_fs
+
+@fs bloom_up_fs
+uniform sampler2D tex;
 
-@fs blur_fs
 in vec2 uv;
+
 out vec4 frag_color;
 
+void main() {
+  vec2 o = 0.5 / vec2(textureSize(tex, 0));
+  vec3 sum = texture(tex, uv + vec2(-o.x * 2.0, 0.0)).rgb;
+  sum += texture(tex, uv + vec2(-o.x,  o.y)).rgb * 2.0;
+  sum += texture(tex, uv + vec2( 0.0,  o.y * 2.0)).rgb;
+  sum += texture(tex, uv + vec2( o.x,  o.y)).rgb * 2.0;
+  sum += texture(tex, uv + vec2( o.x * 2.0, 0.0)).rgb;
+  sum += texture(tex, uv + vec2( o.x, -o.y)).rgb * 2.0;
+  sum += texture(tex, uv + vec2( 0.0, -o.y * 2.0)).rgb;
+  sum += texture(tex, uv + vec2(-o.x, -o.y)).rgb * 2.0;
+  frag_color = vec4(sum / 12.0, 1.0);
+}
+@end
+@program bloom_up fsq_vs bloom_up_fs
+
+/* Separable gaussian blur with the 9-tap kernel folded into 5 bilinear taps:
+ * neighbouring texel pairs are fetched at a weighted offset between them, so
+ * the hardware filter does the weighting. Offsets and weights are computed on
+ * the CPU; `dir` selects the horizontal or vertical pass. */
+@fs blur_fs
 uniform sampler2D tex;
 uniform blur_fs_params {
-  vec2 hori;
+  vec2 dir;
+  vec4 offsets;
+  vec4 weights;
 };
-const float weight[] = { 0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216 };
+
+in vec2 uv;
+
+out vec4 frag_color;
 
 void main() {
-  vec2 tex_offset = 1.0 / textureSize(tex, 0);
-  vec3 result = texture(tex, uv).rgb * weight[0]; // current fragment's contribution
-  for (int i = 1; i < 5; ++i) {
-    result += texture(tex, uv + hori * tex_offset * i).rgb * weight[i];
-    result += texture(tex, uv - hori * tex_offset * i).rgb * weight[i];
-  }
+  vec2 texel = dir / vec2(textureSize(tex, 0));
+  vec3 result = texture(tex, uv).rgb * weights.x;
+  result += texture(tex, uv + texel * offsets.y).rgb * weights.y;
+  result += texture(tex, uv - texel * offsets.y).rgb * weights.y;
+  result += texture(tex, uv + texel * offsets.z).rgb * weights.z;
+  result += texture(tex, uv - texel * offsets.z).rgb * weights.z;
   frag_color = vec4(result, 1.0);
 }
 @end
-@program blur blur_vs blur_fs
+@program blur fsq_vs blur_fs
@@ -43,6 +43,7 @@ typedef struct {
     } image;
     struct {
       const char *text;
+      ol_Font font;
     } text;
   } data;
 } ui_Command;
@@ -95,6 +96,8 @@ typedef struct {
 } HealthbarState;
 
 typedef struct {
+  ol_FontFace font_face;
+  /* what text is drawn with */
   ol_Font font;
   ol_Image atlas;
   char textbuf[TEXBUF_SIZE];
@@ -113,11 +116,20 @@ typedef struct {
 
 static ui_State _ui_state;
 
+#define UI_ATLAS "./ui.png"
+#define UI_FONT "./Orbitron-Regular.ttf"
+
+/* Text after this is drawn `size` pixels high */
+static void ui_font_size(int size) {
+  _ui_state.font = ol_font(&_ui_state.font_face, size);
+}
+
 void ui_init() {
   _ui_state = (ui_State) {
-    .font = ol_load_font("./Orbitron-Regular.ttf"),
-    .atlas = ol_load_image("./ui.png"),
+    .atlas = ol_load_image(UI_ATLAS),
   };
+  ol_load_font_face(UI_FONT, &_ui_state.font_face);
+  ui_font_size(ASSET_FONT_SIZE);
 
   _ui_state.healthbar.pip = sg_make_pipeline(&(sg_pipeline_desc) {
     .layout = (sg_layout_desc) {
@@ -148,6 +160,18 @@ void ui_init() {
   });
 }
 
+/* Looks the atlas up again after ol_reload_atlas, or loads the font again
+ * if `path` is one of them. The font keeps pointing at the face, so text
+ * picks up the new glyphs as is. */
+void ui_reload(const char *path) {
+  if (asset_atlas_find(path) >= 0)
+    _ui_state.atlas = ol_load_image(UI_ATLAS);
+  if (strcmp(path, UI_FONT) == 0) {
+    sg_destroy_image(_ui_state.font_face.img.sg);
+    ol_load_font_face(path, &_ui_state.font_face);
+  }
+}
+
 // -- Cutters --
 _Thread_local ol_Rect _ui_rswap;
 
@@ -361,7 +385,7 @@ static void ui_text(const char *text) {
   ui_addcommand((ui_Command) {
     .kind = Ui_Cmd_Text,
     .rect = rect,
-    .data.text = text,
+    .data.text = { text, _ui_state.font },
   });
 }
 
@@ -518,7 +542,7 @@ static void ui_render() {
   for (ui_Command *cmd = ui_command_next(); cmd != NULL; cmd = ui_command_next()) {
     switch (cmd->kind) {
       case Ui_Cmd_Text: {
-        ol_draw_text(&_ui_state.font, cmd->data.text.text, cmd->rect.x, cmd->rect.y, vec4_f(1.0));
+        ol_draw_text(&cmd->data.text.font, cmd->data.text.text, cmd->rect.x, cmd->rect.y, vec4_f(1.0));
       } break;
       case Ui_Cmd_Frame: {
         ui_Frame frame = cmd->data.frame.frame;
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/* Tells which of a set of files changed on disk, for reloading them while
+ * the game runs.
+ *
+ * On Linux this is inotify on the directories holding the files, so saves
+ * that replace a file by renaming over it are seen as well. Elsewhere the
+ * modification times are compared every watch_next pass. Emscripten has no
+ * files to change and never reports any. */
+
+#define WATCH_MAX_FILES (32)
+#define WATCH_MAX_DIRS (8)
+
+#if defined(__linux__)
+#define WATCH_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif !defined(__EMSCRIPTEN__)
+#define WATCH_STAT
+#include <sys/stat.h>
+#endif
+
+typedef struct {
+  const char *path;
+  bool changed;
+#ifdef WATCH_INOTIFY
+  /* watch descriptor of the directory and the name inside it */
+  int dir;
+  const char *name;
+#elif defined(WATCH_STAT)
+  time_t mtime;
+#endif
+} _watch_File;
+
+static struct {
+  _watch_File files[WATCH_MAX_FILES];
+  size_t file_count;
+#ifdef WATCH_INOTIFY
+  int fd;
+  char dirs[WATCH_MAX_DIRS][128];
+  int dir_wds[WATCH_MAX_DIRS];
+  size_t dir_count;
+#endif
+} _watch_state;
+
+#ifdef WATCH_STAT
+static time_t _watch_mtime(const char *path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? st.st_mtime : 0;
+}
+#endif
+
+__attribute__((unused))
+static void watch_init(void) {
+  memset(&_watch_state, 0, sizeof(_watch_state));
+#ifdef WATCH_INOTIFY
+  _watch_state.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (_watch_state.fd < 0)
+    fprintf(stderr, "Could not watch assets for changes, inotify failed\n");
+#endif
+}
+
+/* Starts watching `path`, which has to outlive the watch */
+__attribute__((unused))
+static void watch_add(const char *path) {
+  for (size_t i = 0; i < _watch_state.file_count; i++)
+    if (strcmp(_watch_state.files[i].path, path) == 0) return;
+  assert(_watch_state.file_count < WATCH_MAX_FILES && "Too many watched files");
+  _watch_File *file = _watch_state.files + _watch_state.file_count++;
+  *file = (_watch_File) { .path = path };
+
+#ifdef WATCH_INOTIFY
+  if (_watch_state.fd < 0) return;
+  const char *slash = strrchr(path, '/');
+  char dir[128];
+  snprintf(dir, sizeof(dir), "%.*s", slash ? (int)(slash - path) : 1, slash ? path : ".");
+  file->name = slash ? slash + 1 : path;
+  file->dir = -1;
+
+  /* one watch per directory, inotify hands out the same descriptor again anyway */
+  for (size_t i = 0; i < _watch_state.dir_count && file->dir < 0; i++)
+    if (strcmp(_watch_state.dirs[i], dir) == 0)
+      file->dir = _watch_state.dir_wds[i];
+  if (file->dir >= 0 || _watch_state.dir_count == WATCH_MAX_DIRS) return;
+  file->dir = inotify_add_watch(_watch_state.fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (file->dir < 0) {
+    fprintf(stderr, "Could not watch %s for changes\n", dir);
+    return;
+  }
+  snprintf(_watch_state.dirs[_watch_state.dir_count], sizeof(_watch_state.dirs[0]), "%s", dir);
+  _watch_state.dir_wds[_watch_state.dir_count++] = file->dir;
+#elif defined(WATCH_STAT)
+  file->mtime = _watch_mtime(path);
+#endif
+}
+
+static const char *_watch_take_changed(void) {
+  for (size_t i = 0; i < _watch_state.file_count; i++) {
+    _watch_File *file = _watch_state.files + i;
+    if (!file->changed) continue;
+    file->changed = false;
+    return file->path;
+  }
+  return NULL;
+}
+
+/* The next watched file that changed since it was last returned, NULL once
+ * there are no more. Call it until it returns NULL, once a frame. */
+__attribute__((unused))
+static const char *watch_next(void) {
+  const char *path = _watch_take_changed();
+  if (path != NULL) return path;
+
+#ifdef WATCH_INOTIFY
+  if (_watch_state.fd < 0) return NULL;
+  /* aligned for the events, each is followed by its name */
+  char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  for (;;) {
+    ssize_t size = read(_watch_state.fd, buffer, sizeof(buffer));
+    if (size <= 0) break;
+    for (char *at = buffer; at < buffer + size;) {
+      const struct inotify_event *event = (const struct inotify_event*)at;
+      at += sizeof(*event) + event->len;
+      if (event->len == 0) continue;
+      for (size_t i = 0; i < _watch_state.file_count; i++) {
+        _watch_File *file = _watch_state.files + i;
+        if (file->dir == event->wd && strcmp(file->name, event->name) == 0)
+          file->changed = true;
+      }
+    }
+  }
+#elif defined(WATCH_STAT)
+  for (size_t i = 0; i < _watch_state.file_count; i++) {
+    _watch_File *file = _watch_state.files + i;
+    time_t mtime = _watch_mtime(file->path);
+    if (mtime != 0 && mtime != file->mtime) {
+      file->mtime = mtime;
+      file->changed = true;
+    }
+  }
+#endif
+  return _watch_take_changed();
+}
+
+__attribute__((unused))
+static void watch_shutdown(void) {
+#ifdef WATCH_INOTIFY
+  if (_watch_state.fd >= 0)
+    close(_watch_state.fd);
+  _watch_state.fd = -1;
+#endif
+  _watch_state.file_count = 0;
+}
@@ -0,0 +1,227 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/* Background worker threads.
+ *
+ * A job's `run` is called on one of the workers, then its `finish` on the
+ * main thread by the next worker_finish, so only `finish` may touch
+ * sokol_gfx or the game state. Without threads (emscripten, or if none could
+ * be started) worker_finish runs one waiting job per call instead, which
+ * still keeps frames coming. */
+
+#ifdef __EMSCRIPTEN__
+#define WORKER_THREADS (0)
+#else
+#define WORKER_THREADS (1)
+#endif
+
+#define WORKER_MAX_JOBS (64)
+#define WORKER_MAX_THREADS (8)
+
+#if WORKER_THREADS
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK _worker_Mutex;
+typedef CONDITION_VARIABLE _worker_Cond;
+typedef HANDLE _worker_Thread;
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_mutex_t _worker_Mutex;
+typedef pthread_cond_t _worker_Cond;
+typedef pthread_t _worker_Thread;
+#endif
+#endif
+
+typedef void (*worker_Fn)(void *arg);
+
+typedef struct {
+  worker_Fn run, finish;
+  void *arg;
+} worker_Job;
+
+static struct {
+  /* ring buffers of jobs waiting for a worker, and of jobs waiting for worker_finish */
+  worker_Job todo[WORKER_MAX_JOBS], done[WORKER_MAX_JOBS];
+  size_t todo_head, todo_count, done_head, done_count;
+  /* pushed, but not finished yet */
+  size_t pending;
+#if WORKER_THREADS
+  _worker_Mutex mutex;
+  _worker_Cond wake;
+  _worker_Thread threads[WORKER_MAX_THREADS];
+  size_t thread_count;
+  bool quit;
+#endif
+} _worker_state;
+
+#if WORKER_THREADS
+#ifdef _WIN32
+static void _worker_lock(void) { AcquireSRWLockExclusive(&_worker_state.mutex); }
+static void _worker_unlock(void) { ReleaseSRWLockExclusive(&_worker_state.mutex); }
+static void _worker_wait(void) { SleepConditionVariableSRW(&_worker_state.wake, &_worker_state.mutex, INFINITE, 0); }
+static void _worker_wake_one(void) { WakeConditionVariable(&_worker_state.wake); }
+static void _worker_wake_all(void) { WakeAllConditionVariable(&_worker_state.wake); }
+#else
+static void _worker_lock(void) { pthread_mutex_lock(&_worker_state.mutex); }
+static void _worker_unlock(void) { pthread_mutex_unlock(&_worker_state.mutex); }
+static void _worker_wait(void) { pthread_cond_wait(&_worker_state.wake, &_worker_state.mutex); }
+static void _worker_wake_one(void) { pthread_cond_signal(&_worker_state.wake); }
+static void _worker_wake_all(void) { pthread_cond_broadcast(&_worker_state.wake); }
+#endif
+
+static void _worker_loop(void) {
+  _worker_lock();
+  for (;;) {
+    while (_worker_state.todo_count == 0 && !_worker_state.quit)
+      _worker_wait();
+    if (_worker_state.quit) break;
+
+    worker_Job job = _worker_state.todo[_worker_state.todo_head];
+    _worker_state.todo_head = (_worker_state.todo_head + 1) % WORKER_MAX_JOBS;
+    _worker_state.todo_count--;
+    _worker_unlock();
+
+    job.run(job.arg);
+
+    _worker_lock();
+    /* can't overflow, there are never more than WORKER_MAX_JOBS pending */
+    size_t tail = (_worker_state.done_head + _worker_state.done_count++) % WORKER_MAX_JOBS;
+    _worker_state.done[tail] = job;
+  }
+  _worker_unlock();
+}
+
+#ifdef _WIN32
+static DWORD WINAPI _worker_main(LPVOID unused) {
+  (void)unused;
+  _worker_loop();
+  return 0;
+}
+#else
+static void *_worker_main(void *unused) {
+  (void)unused;
+  _worker_loop();
+  return NULL;
+}
+#endif
+#endif
+
+/* Logical cores, counting the calling thread's */
+__attribute__((unused))
+static size_t worker_core_count(void) {
+#if !WORKER_THREADS
+  return 1;
+#elif defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (size_t)count : 1;
+#endif
+}
+
+/* Starts the workers, one less than there are cores so the main thread keeps one */
+__attribute__((unused))
+static void worker_init(void) {
+  memset(&_worker_state, 0, sizeof(_worker_state));
+#if WORKER_THREADS
+  size_t count = worker_core_count() - 1;
+  if (count < 1) count = 1;
+  if (count > WORKER_MAX_THREADS) count = WORKER_MAX_THREADS;
+
+#ifdef _WIN32
+  InitializeSRWLock(&_worker_state.mutex);
+  InitializeConditionVariable(&_worker_state.wake);
+  for (size_t i = 0; i < count; i++) {
+    _worker_state.threads[i] = CreateThread(NULL, 0, _worker_main, NULL, 0, NULL);
+    if (_worker_state.threads[i] == NULL) break;
+    _worker_state.thread_count++;
+  }
+#else
+  pthread_mutex_init(&_worker_state.mutex, NULL);
+  pthread_cond_init(&_worker_state.wake, NULL);
+  for (size_t i = 0; i < count; i++) {
+    if (pthread_create(_worker_state.threads + i, NULL, _worker_main, NULL) != 0) break;
+    _worker_state.thread_count++;
+  }
+#endif
+#endif
+}
+
+/* Queues `run(arg)` for a worker, and `finish(arg)` for the main thread afterwards */
+__attribute__((unused))
+static void worker_push(worker_Fn run, worker_Fn finish, void *arg) {
+  assert(_worker_state.pending < WORKER_MAX_JOBS && "Too many worker jobs in flight");
+  _worker_state.pending++;
+#if WORKER_THREADS
+  _worker_lock();
+#endif
+  size_t tail = (_worker_state.todo_head + _worker_state.todo_count++) % WORKER_MAX_JOBS;
+  _worker_state.todo[tail] = (worker_Job) { run, finish, arg };
+#if WORKER_THREADS
+  _worker_unlock();
+  _worker_wake_one();
+#endif
+}
+
+/* Calls `finish` for every job whose `run` has returned, call once a frame */
+__attribute__((unused))
+static void worker_finish(void) {
+  worker_Job done[WORKER_MAX_JOBS];
+  size_t count = 0;
+  bool threaded = false;
+#if WORKER_THREADS
+  threaded = _worker_state.thread_count > 0;
+  if (threaded) {
+    _worker_lock();
+    for (; _worker_state.done_count > 0; _worker_state.done_count--) {
+      done[count++] = _worker_state.done[_worker_state.done_head];
+      _worker_state.done_head = (_worker_state.done_head + 1) % WORKER_MAX_JOBS;
+    }
+    _worker_unlock();
+  }
+#endif
+  if (!threaded && _worker_state.todo_count > 0) {
+    done[count] = _worker_state.todo[_worker_state.todo_head];
+    _worker_state.todo_head = (_worker_state.todo_head + 1) % WORKER_MAX_JOBS;
+    _worker_state.todo_count--;
+    done[count].run(done[count].arg);
+    count++;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    done[i].finish(done[i].arg);
+    _worker_state.pending--;
+  }
+}
+
+/* Whether any pushed job hasn't been finished yet */
+__attribute__((unused))
+static bool worker_busy(void) {
+  return _worker_state.pending > 0;
+}
+
+/* Waits for the running jobs, those still queued are dropped without being finished */
+__attribute__((unused))
+static void worker_shutdown(void) {
+#if WORKER_THREADS
+  _worker_lock();
+  _worker_state.quit = true;
+  _worker_unlock();
+  _worker_wake_all();
+  for (size_t i = 0; i < _worker_state.thread_count; i++) {
+#ifdef _WIN32
+    WaitForSingleObject(_worker_state.threads[i], INFINITE);
+    CloseHandle(_worker_state.threads[i]);
+#else
+    pthread_join(_worker_state.threads[i], NULL);
+#endif
+  }
+  _worker_state.thread_count = 0;
+#endif
+}